@@ -17,6 +17,12 @@
 //   hps-sim   //
 //-------------//
 #include "SimPlugin.h"
+#include "VolumeTags.h"
+
+//------------//
+//   Geant4   //
+//------------//
+#include "G4UImessenger.hh"
 
 namespace hpssim {
 
@@ -24,6 +30,17 @@ namespace hpssim {
 
         public:
 
+            /**
+             * Constructor.
+             * Creates a messenger for setting the parameters of the filter.
+             */
+            WabConvFilter();
+
+            /**
+             * Destructor.
+             */
+            virtual ~WabConvFilter();
+
             /**
              * Get the name of the plugin.
              * @return The name of the plugin.
@@ -33,7 +50,19 @@ namespace hpssim {
             /**
              * Get the user actions that will be called by this plugin. 
              */
-            inline std::vector<PluginAction> getActions() { return {PluginAction::STEPPING, PluginAction::EVENT}; }
+            inline std::vector<PluginAction> getActions() { 
+                return {PluginAction::STEPPING, PluginAction::EVENT, PluginAction::STAGING}; 
+            }
+
+            /**
+             * Read the parameters and define the tags of the tracker layers.
+             */
+            void initialize();
+
+            /**
+             * Only steps of photons in the first three tracker layers are passed to the stepping action.
+             */
+            SteppingFilter getSteppingFilter();
 
             /**
              * End of event action.
@@ -46,11 +75,38 @@ namespace hpssim {
              */
             void stepping(const G4Step* step);
 
+            /**
+             * Simulate the primary photons first so the event can be rejected before the 
+             * rest of it is showered.
+             * @param track The new track.
+             */
+            bool stagingIsFirstStage(const G4Track* track);
+
+            /**
+             * By default, the event is only vetoed by the stepping action, so it is always
+             * accepted here.  If the 'rejectUnconverted' parameter is set to 1, events where
+             * the wide angle brem did not convert while the photons were simulated are also
+             * rejected before the postponed tracks are simulated.
+             * @param stage The stage which was completed.
+             */
+            bool stagingAcceptEvent(int stage);
+
         private:
 
+            /** The messenger for setting the parameters of the filter. */
+            G4UImessenger* messenger_;
+
+            /** Flag to reject events where the wide angle brem did not convert in the first stage. */
+            bool rejectUnconverted_{false};
+
             /** Process to filter on. */
             std::string processName_{""};
 
+            /** Tags of the modules of the first, second and third tracker layers. */
+            VolumeTags::Mask layer1Tag_{0};
+            VolumeTags::Mask layer2Tag_{0};
+            VolumeTags::Mask layer3Tag_{0};
+
             /** Flag that denotes whether a conversion has been found. */
             bool hasWabConv_{false}; 
 
@@ -7,6 +7,11 @@
 
 #include "WabConvFilter.h"
 
+//-------------//
+//   hps-sim   //
+//-------------//
+#include "SimPluginMessenger.h"
+
 //------------//
 //   Geant4   //
 //------------//
@@ -14,6 +19,30 @@
 
 namespace hpssim {
 
+    WabConvFilter::WabConvFilter() {
+        messenger_ = new SimPluginMessenger(this);
+    }
+
+    WabConvFilter::~WabConvFilter() {
+        delete messenger_;
+    }
+
+    void WabConvFilter::initialize() {
+        rejectUnconverted_ = getParameters().get("rejectUnconverted", 0.) != 0.;
+
+        VolumeTags* tags = VolumeTags::getVolumeTags();
+        layer1Tag_ = tags->defineTag("svtL1", "module_L1");
+        layer2Tag_ = tags->defineTag("svtL2", "module_L2");
+        layer3Tag_ = tags->defineTag("svtL3", "module_L3");
+    }
+
+    SimPlugin::SteppingFilter WabConvFilter::getSteppingFilter() {
+        SteppingFilter filter;
+        filter.pdgCodes = {22};
+        filter.volumeTags = layer1Tag_ | layer2Tag_ | layer3Tag_;
+        return filter;
+    }
+
     void WabConvFilter::stepping(const G4Step* step) { 
         
         if (hasWabConv_) return; 
@@ -21,20 +50,11 @@ namespace hpssim {
         // Get the track associated with this step.
         G4Track* track = step->GetTrack();
 
-        // get the PDGID of the track.
-        G4int pdgID = track->GetParticleDefinition()->GetPDGEncoding();
-
-        // Make sure that the first particle that is processed is a photon. 
-        // If another particle is encountered before the wide angle brem, 
-        // put it on the waiting stack.
-        if (pdgID != 22) return;
+        // Only photons are passed by the stepping filter.
 
         // Get the volume the particle is in.
         G4VPhysicalVolume* volume = track->GetVolume();
-        G4String volumeName = volume->GetName();
-
-        // Get the particle type.
-        G4String particleName = track->GetParticleDefinition()->GetParticleName();
+        VolumeTags::Mask volumeTags = VolumeTags::getVolumeTags()->getTags(volume);
         
         // Get the kinetic energy of the particle.
         //double incidentParticleEnergy = step->GetPostStepPoint()->GetTotalEnergy();
@@ -45,25 +65,24 @@ namespace hpssim {
         std::cout << "********************************" << std::endl;
 
         std::cout << "[ TargetBremFilter ]: " << "\n" 
-                    << "\tTotal energy of " << particleName      << " ( PDG ID: " << pdgID
+                    << "\tTotal energy of " << track->GetParticleDefinition()->GetParticleName() << " ( PDG ID: " << pdgID
                     << " ) : " << incidentParticleEnergy       << "\n"
                     << "\tTrack ID: " << track->GetTrackID()     << "\n" 
                     << "\tStep #: " << track->GetCurrentStepNumber() << "\n"
-                    << "\tParticle currently in " << volumeName  
+                    << "\tParticle currently in " << volume->GetName()  
                     << "\tPost step process: " << step->GetPostStepPoint()->GetStepStatus() 
                     << std::endl;*/
 
         // Only conversions that happen in the target, first or second layers
         // of the tracker are of interest.  If the photon has propagated past
         // the second layer and didn't convert, kill the event.
-        if (volumeName.find("module_L3") != std::string::npos) {
+        if (volumeTags & layer3Tag_) {
             /*std::cout << "[ WabConvFilter ]: Photon is beyond the sensitive" 
                       << " detectors of interest. Killing event." << std::endl;*/
             track->SetTrackStatus(fKillTrackAndSecondaries); 
             G4RunManager::GetRunManager()->AbortEvent();
             return;
-        } else if ((volumeName.find("module_L1") == std::string::npos) &&
-                    (volumeName.find("module_L2") == std::string::npos)) {
+        } else if (!(volumeTags & (layer1Tag_ | layer2Tag_))) {
             /*std::cout << "[ WabConvFilter ]: Photon is not within sensitive " 
                       << " detectors of interest." << std::endl;*/
             return;
@@ -73,7 +92,7 @@ namespace hpssim {
         const std::vector<const G4Track*>* secondaries = step->GetSecondaryInCurrentStep();
            
         /*std::cout << "[ WabConvFilter ]: "
-                  << particleName  << " produced " << secondaries->size() 
+                  << track->GetParticleDefinition()->GetParticleName()  << " produced " << secondaries->size() 
                   << " secondaries." << std::endl;*/
 
             // If the particle didn't produce any secondaries, stop processing
@@ -89,7 +108,7 @@ namespace hpssim {
         if (processName.compareTo("conv") == 0) { 
             hasWabConv_ = true;
             std::cout << "[ WabConvFilter ]: " 
-                      << "WAB converted in " << volumeName << std::endl;
+                      << "WAB converted in " << volume->GetName() << std::endl;
 
         } else { 
             track->SetTrackStatus(fKillTrackAndSecondaries);
@@ -98,6 +117,16 @@ namespace hpssim {
         } 
     }
 
+    bool WabConvFilter::stagingIsFirstStage(const G4Track* track) { 
+        return track->GetParentID() == 0 && track->GetParticleDefinition()->GetPDGEncoding() == 22;
+    }
+
+    bool WabConvFilter::stagingAcceptEvent(int) { 
+        // The stepping action aborts the events which are vetoed, so by default the
+        // photons are only simulated first to reach that decision sooner.
+        return hasWabConv_ || !rejectUnconverted_;
+    }
+
     void WabConvFilter::endEvent(const G4Event*) { 
         hasWabConv_ = false; 
     }
@@ -0,0 +1,378 @@
+/**
+ * @file AcceptancePlugin.cxx
+ * @brief Class that defines a sim plugin which kills tracks leaving the target outside the detector acceptance
+ */
+
+#include "SimPlugin.h"
+#include "SimPluginMessenger.h"
+#include "UserTrackInformation.h"
+#include "VolumeTags.h"
+
+#include "G4AffineTransform.hh"
+#include "G4LogicalVolume.hh"
+#include "G4Navigator.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4TransportationManager.hh"
+#include "G4UImessenger.hh"
+#include "G4VisExtent.hh"
+#include "G4VSolid.hh"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+namespace hpssim {
+
+/**
+ * @class AcceptancePlugin
+ * @brief Plugin for killing tracks which leave the target in directions that cannot reach any sensitive detector
+ *
+ * @note
+ * At the start of the run, an acceptance map is built by tracing straight rays through the
+ * geometry with a G4Navigator from cells of the exit position on the target face and of the
+ * direction, which is binned in the horizontal angle atan2(px, pz) and the vertical angle
+ * asin(py / p) over the full sphere.  A cell is accepted if a ray from its center or any of
+ * its corners enters a volume with a sensitive detector, and accepted cells are then widened
+ * by a margin of neighboring cells.
+ *
+ * @par
+ * Neutral tracks use the full map.  The dipole field is vertical, so charged tracks keep the
+ * sign of their vertical angle and can only reach points which are at least as steep as it,
+ * so a charged track is accepted if any direction at the same or a steeper vertical angle on
+ * the same side is accepted.  This generalizes the thetaY cuts of BeamTrackSelectionPlugin.
+ * Tracks outside of the acceptance are killed when they leave the target, and they are only
+ * saved as MCParticles if the saveKilled parameter is set.
+ */
+class AcceptancePlugin: public SimPlugin {
+
+    public:
+
+        AcceptancePlugin() {
+            messenger_ = new SimPluginMessenger(this);
+        }
+
+        virtual ~AcceptancePlugin() {
+            delete messenger_;
+        }
+
+        virtual std::string getName() {
+            return "AcceptancePlugin";
+        }
+
+        std::vector<PluginAction> getActions() {
+            return {PluginAction::RUN, PluginAction::STEPPING};
+        }
+
+        void initialize() {
+            Parameters& params = getParameters();
+            int alphaBins = params.get("alphaBins", alphaBins_);
+            int lambdaBins = params.get("lambdaBins", lambdaBins_);
+            int positionBins = params.get("positionBins", positionBins_);
+            int margin = params.get("margin", margin_);
+            saveKilled_ = params.get("saveKilled", saveKilled_);
+
+            // The target is tagged with the same pattern as in BeamTrackSelectionPlugin.
+            targetTag_ = VolumeTags::getVolumeTags()->defineTag("target", "^" + volumeName_ + "$");
+
+            // Rebuild the map only if its settings changed.
+            if (accepted_.empty() || alphaBins != alphaBins_ || lambdaBins != lambdaBins_
+                    || positionBins != positionBins_ || margin != margin_) {
+                alphaBins_ = std::max(alphaBins, 1);
+                lambdaBins_ = std::max(lambdaBins, 1);
+                positionBins_ = std::max(positionBins, 1);
+                margin_ = std::max(margin, 0);
+                buildMap();
+            }
+        }
+
+        /**
+         * Only steps leaving the target are passed to the stepping action.
+         */
+        SteppingFilter getSteppingFilter() {
+            SteppingFilter filter;
+            filter.volumeTags = targetTag_;
+            filter.boundaryOnly = true;
+            return filter;
+        }
+
+        void beginRun(const G4Run*) {
+            nKilled_ = 0;
+            nChecked_ = 0;
+        }
+
+        void endRun(const G4Run*) {
+            std::cout << "AcceptancePlugin: Killed " << nKilled_ << " of " << nChecked_
+                    << " tracks leaving the target outside the acceptance" << std::endl;
+        }
+
+        void stepping(const G4Step* step) {
+            if (accepted_.empty()
+                    || VolumeTags::getVolumeTags()->hasTag(step->GetPostStepPoint()->GetPhysicalVolume(), targetTag_)) {
+                return;
+            }
+            G4Track* track = step->GetTrack();
+            ++nChecked_;
+            if (isAccepted(step->GetPostStepPoint()->GetPosition(), track->GetMomentumDirection(),
+                    track->GetDefinition()->GetPDGCharge() != 0)) {
+                return;
+            }
+            if (verbose_ > 2) {
+                std::cout << "AcceptancePlugin: Killing track " << track->GetTrackID() << " with PID "
+                        << track->GetDefinition()->GetPDGEncoding() << " and momentum " << track->GetMomentum()
+                        << " outside the acceptance" << std::endl;
+            }
+            track->SetTrackStatus(fStopAndKill);
+            UserTrackInformation::getUserTrackInformation(track)->setSaveFlag(saveKilled_);
+            ++nKilled_;
+        }
+
+    private:
+
+        /** Maximum number of navigation steps of a ray. */
+        static const int MAX_RAY_STEPS = 1000;
+
+        /**
+         * Return true if a track leaving the target is inside the acceptance.
+         * Tracks outside of the position range of the map are always accepted.
+         */
+        bool isAccepted(const G4ThreeVector& position, const G4ThreeVector& direction, bool charged) const {
+            int ix = (int) std::floor((position.x() - xMin_) / (xMax_ - xMin_) * positionBins_);
+            int iy = (int) std::floor((position.y() - yMin_) / (yMax_ - yMin_) * positionBins_);
+            if (ix < 0 || ix >= positionBins_ || iy < 0 || iy >= positionBins_) {
+                return true;
+            }
+            int positionCell = ix * positionBins_ + iy;
+            double lambda = std::asin(std::max(-1., std::min(1., direction.y())));
+            int iLambda = std::min((int) ((lambda + M_PI / 2) / M_PI * lambdaBins_), lambdaBins_ - 1);
+            if (charged) {
+                return chargedAccepted_[positionCell * lambdaBins_ + iLambda];
+            }
+            double alpha = std::atan2(direction.x(), direction.z());
+            int iAlpha = std::min((int) ((alpha + M_PI) / (2 * M_PI) * alphaBins_), alphaBins_ - 1);
+            return accepted_[(positionCell * lambdaBins_ + iLambda) * alphaBins_ + iAlpha];
+        }
+
+        static G4ThreeVector toDirection(double alpha, double lambda) {
+            return G4ThreeVector(std::cos(lambda) * std::sin(alpha), std::sin(lambda), std::cos(lambda) * std::cos(alpha));
+        }
+
+        static G4VPhysicalVolume* findMother(const G4VPhysicalVolume* volume) {
+            for (auto mother : *G4PhysicalVolumeStore::GetInstance()) {
+                if (mother->GetLogicalVolume()->IsDaughter(volume)) {
+                    return mother;
+                }
+            }
+            return nullptr;
+        }
+
+        /**
+         * Find the global extent of the target in x and y and the z of its center.
+         * @return False if the target volume does not exist.
+         */
+        bool findTarget(double& zCenter) {
+            G4VPhysicalVolume* target = nullptr;
+            for (auto volume : *G4PhysicalVolumeStore::GetInstance()) {
+                if (volume->GetName() == volumeName_) {
+                    target = volume;
+                    break;
+                }
+            }
+            if (!target) {
+                return false;
+            }
+
+            // Combine the placements of the target and its mothers into its global transform.
+            G4AffineTransform transform;
+            for (G4VPhysicalVolume* volume = target; volume; volume = findMother(volume)) {
+                transform = transform * G4AffineTransform(volume->GetRotation(), volume->GetTranslation());
+            }
+
+            G4VisExtent extent = target->GetLogicalVolume()->GetSolid()->GetExtent();
+            xMin_ = yMin_ = DBL_MAX;
+            xMax_ = yMax_ = -DBL_MAX;
+            zCenter = 0.;
+            for (int corner = 0; corner < 8; corner++) {
+                G4ThreeVector point = transform.TransformPoint(
+                        G4ThreeVector(corner & 1 ? extent.GetXmax() : extent.GetXmin(),
+                                corner & 2 ? extent.GetYmax() : extent.GetYmin(),
+                                corner & 4 ? extent.GetZmax() : extent.GetZmin()));
+                xMin_ = std::min(xMin_, point.x());
+                xMax_ = std::max(xMax_, point.x());
+                yMin_ = std::min(yMin_, point.y());
+                yMax_ = std::max(yMax_, point.y());
+                zCenter += point.z() / 8;
+            }
+            return true;
+        }
+
+        /**
+         * Trace a straight ray through the geometry.
+         * @return True if the ray enters a volume with a sensitive detector.
+         */
+        bool reachesSensitiveDetector(G4Navigator* navigator, G4ThreeVector position, const G4ThreeVector& direction) {
+            G4VPhysicalVolume* volume = navigator->LocateGlobalPointAndSetup(position, &direction, false, false);
+            for (int i = 0; i < MAX_RAY_STEPS && volume; i++) {
+                // The ray starts inside the target, which is not checked.
+                if (i && volume->GetLogicalVolume()->GetSensitiveDetector()) {
+                    return true;
+                }
+                double safety;
+                double step = navigator->ComputeStep(position, direction, kInfinity, safety);
+                if (step == kInfinity) {
+                    return false;
+                }
+                position += step * direction;
+                navigator->SetGeometricallyLimitedStep();
+                volume = navigator->LocateGlobalPointAndSetup(position, &direction, true);
+            }
+            return false;
+        }
+
+        /**
+         * Build the acceptance maps of neutral and charged tracks.
+         */
+        void buildMap() {
+            accepted_.clear();
+            chargedAccepted_.clear();
+
+            double zCenter;
+            if (!findTarget(zCenter)) {
+                G4Exception("AcceptancePlugin::buildMap", "", JustWarning,
+                        G4String("The target volume '" + volumeName_ + "' does not exist so no tracks are killed."));
+                return;
+            }
+
+            G4VPhysicalVolume* world =
+                    G4TransportationManager::GetTransportationManager()->GetNavigatorForTracking()->GetWorldVolume();
+            G4Navigator navigator;
+            navigator.SetWorldVolume(world);
+
+            std::cout << "AcceptancePlugin: Building acceptance map with " << positionBins_ << " x " << positionBins_
+                    << " position bins, " << alphaBins_ << " horizontal and " << lambdaBins_
+                    << " vertical angle bins" << std::endl;
+
+            double alphaStep = 2 * M_PI / alphaBins_;
+            double lambdaStep = M_PI / lambdaBins_;
+            size_t nCells = (size_t) positionBins_ * positionBins_ * lambdaBins_ * alphaBins_;
+            accepted_.assign(nCells, 0);
+            chargedAccepted_.assign((size_t) positionBins_ * positionBins_ * lambdaBins_, 0);
+            std::vector<char> corners((lambdaBins_ + 1) * alphaBins_);
+            std::vector<char> hits(lambdaBins_ * alphaBins_);
+            size_t nAccepted = 0;
+
+            for (int ix = 0; ix < positionBins_; ix++) {
+                for (int iy = 0; iy < positionBins_; iy++) {
+                    G4ThreeVector start(xMin_ + (ix + 0.5) * (xMax_ - xMin_) / positionBins_,
+                            yMin_ + (iy + 0.5) * (yMax_ - yMin_) / positionBins_, zCenter);
+
+                    // Rays through the corners of the direction cells, which wrap around in the horizontal angle.
+                    for (int iLambda = 0; iLambda <= lambdaBins_; iLambda++) {
+                        for (int iAlpha = 0; iAlpha < alphaBins_; iAlpha++) {
+                            corners[iLambda * alphaBins_ + iAlpha] = reachesSensitiveDetector(&navigator, start,
+                                    toDirection(-M_PI + iAlpha * alphaStep, -M_PI / 2 + iLambda * lambdaStep));
+                        }
+                    }
+                    for (int iLambda = 0; iLambda < lambdaBins_; iLambda++) {
+                        for (int iAlpha = 0; iAlpha < alphaBins_; iAlpha++) {
+                            int nextAlpha = (iAlpha + 1) % alphaBins_;
+                            hits[iLambda * alphaBins_ + iAlpha] = corners[iLambda * alphaBins_ + iAlpha]
+                                    || corners[iLambda * alphaBins_ + nextAlpha]
+                                    || corners[(iLambda + 1) * alphaBins_ + iAlpha]
+                                    || corners[(iLambda + 1) * alphaBins_ + nextAlpha]
+                                    || reachesSensitiveDetector(&navigator, start,
+                                            toDirection(-M_PI + (iAlpha + 0.5) * alphaStep,
+                                                    -M_PI / 2 + (iLambda + 0.5) * lambdaStep));
+                        }
+                    }
+
+                    // Widen the accepted cells by the margin.
+                    int positionCell = ix * positionBins_ + iy;
+                    char* cells = &accepted_[(size_t) positionCell * lambdaBins_ * alphaBins_];
+                    for (int iLambda = 0; iLambda < lambdaBins_; iLambda++) {
+                        for (int iAlpha = 0; iAlpha < alphaBins_; iAlpha++) {
+                            if (!hits[iLambda * alphaBins_ + iAlpha]) {
+                                continue;
+                            }
+                            for (int jLambda = std::max(iLambda - margin_, 0);
+                                    jLambda <= std::min(iLambda + margin_, lambdaBins_ - 1); jLambda++) {
+                                for (int dAlpha = -margin_; dAlpha <= margin_; dAlpha++) {
+                                    int jAlpha = ((iAlpha + dAlpha) % alphaBins_ + alphaBins_) % alphaBins_;
+                                    cells[jLambda * alphaBins_ + jAlpha] = 1;
+                                }
+                            }
+                        }
+                    }
+
+                    // Charged tracks are accepted if any direction at least as steep on the same side is.
+                    std::vector<char> rows(lambdaBins_, 0);
+                    for (int iLambda = 0; iLambda < lambdaBins_; iLambda++) {
+                        for (int iAlpha = 0; iAlpha < alphaBins_; iAlpha++) {
+                            if (cells[iLambda * alphaBins_ + iAlpha]) {
+                                rows[iLambda] = 1;
+                                ++nAccepted;
+                            }
+                        }
+                    }
+                    char* charged = &chargedAccepted_[(size_t) positionCell * lambdaBins_];
+                    for (int iLambda = 0; iLambda < lambdaBins_; iLambda++) {
+                        double lower = -M_PI / 2 + iLambda * lambdaStep;
+                        double upper = lower + lambdaStep;
+                        int first = lower >= 0 ? iLambda : 0;
+                        int last = upper <= 0 ? iLambda : lambdaBins_ - 1;
+                        charged[iLambda] = std::find(rows.begin() + first, rows.begin() + last + 1, 1)
+                                != rows.begin() + last + 1;
+                    }
+                }
+            }
+
+            std::cout << "AcceptancePlugin: " << nAccepted << " of " << nCells << " cells are accepted" << std::endl;
+        }
+
+    private:
+
+        /** Name of target volume in geometry. */
+        std::string volumeName_{"target_vol"};
+
+        /** Tag of the target volume. */
+        VolumeTags::Mask targetTag_{0};
+
+        /** Number of bins of the horizontal angle. */
+        int alphaBins_{360};
+
+        /** Number of bins of the vertical angle. */
+        int lambdaBins_{180};
+
+        /** Number of bins of the exit position in x and in y. */
+        int positionBins_{1};
+
+        /** Number of neighboring cells which are also accepted around accepted cells. */
+        int margin_{1};
+
+        /** True to save killed tracks as MCParticles. */
+        bool saveKilled_{false};
+
+        /** Extent of the target in x and y. */
+        double xMin_{0.};
+        double xMax_{0.};
+        double yMin_{0.};
+        double yMax_{0.};
+
+        /** Acceptance of neutral tracks by position, vertical and horizontal angle cell. */
+        std::vector<char> accepted_;
+
+        /** Acceptance of charged tracks by position and vertical angle cell. */
+        std::vector<char> chargedAccepted_;
+
+        /** Number of tracks killed in the run. */
+        long nKilled_{0};
+
+        /** Number of tracks leaving the target in the run. */
+        long nChecked_{0};
+
+        /** Plugin messenger for UI commands. */
+        G4UImessenger* messenger_;
+};
+}
+
+SIM_PLUGIN(hpssim, AcceptancePlugin)
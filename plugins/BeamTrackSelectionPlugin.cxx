@@ -7,6 +7,7 @@
 #include "SimPlugin.h"
 #include "SimPluginMessenger.h"
 #include "UserTrackInformation.h"
+#include "VolumeTags.h"
 
 #include "G4AntiNeutron.hh"
 #include "G4AntiProton.hh"
@@ -52,6 +53,9 @@ class BeamTrackSelectionPlugin: public SimPlugin {
             electronEnergyCut_ = params.get("electronEnergyCut", electronEnergyCut_);
             electronEnergyThreshold_ = params.get("electronEnergyThreshold", electronEnergyThreshold_);
 
+            // Tag the target volume so it is found without comparing names in every step.
+            targetTag_ = VolumeTags::getVolumeTags()->defineTag("target", "^" + volumeName_ + "$");
+
             // TODO: Compute energy cuts automatically from particle energy (beam E) if not set from parameters.
         }
 
@@ -83,47 +87,50 @@ class BeamTrackSelectionPlugin: public SimPlugin {
             ++nTracks_;
         }
 
+        /**
+         * Only steps leaving the target are passed to the stepping action.
+         */
+        SteppingFilter getSteppingFilter() {
+            SteppingFilter filter;
+            filter.volumeTags = targetTag_;
+            filter.boundaryOnly = true;
+            return filter;
+        }
+
         void stepping(const G4Step* step) {
-            if (volumeName_.compare(step->GetTrack()->GetVolume()->GetName())) {
-                return;
+            if (verbose_ > 3) {
+                std::cout << "BeamTrackSelectionPlugin: Processing track " << step->GetTrack()->GetTrackID()
+                        << " at " << step->GetPreStepPoint()->GetPosition() << " stepping from '"
+                        << step->GetPreStepPoint()->GetPhysicalVolume()->GetName() << "' to '"
+                        << step->GetPostStepPoint()->GetPhysicalVolume()->GetName() << std::endl;
             }
-            if (step->GetPostStepPoint()->GetStepStatus() == fGeomBoundary) {
-                if (!volumeName_.compare(step->GetPreStepPoint()->GetPhysicalVolume()->GetName())) {
-                    if (verbose_ > 3) {
-                        std::cout << "BeamTrackSelectionPlugin: Processing track " << step->GetTrack()->GetTrackID()
-                                << " at " << step->GetPreStepPoint()->GetPosition() << " stepping from '"
-                                << step->GetPreStepPoint()->GetPhysicalVolume()->GetName() << "' to '"
-                                << step->GetPostStepPoint()->GetPhysicalVolume()->GetName() << std::endl;
-                    }
-
-                    G4Track* track = step->GetTrack();
-                    if (!passes(track)) {
-                        if (verbose_ > 2) {
-                            std::cout << "BeamTrackSelectionPlugin: Track " << track->GetTrackID() << " with PID "
-                                    << track->GetParticleDefinition()->GetPDGEncoding() << " and momentum "
-                                    << track->GetMomentum() << " failed selection" << std::endl;
-                        }
-
-                        // Stop and kill the track; let secondaries propagate.
-                        step->GetTrack()->SetTrackStatus(G4TrackStatus::fStopAndKill);
-
-                        // Do not save this track in output particle coll.
-                        UserTrackInformation::getUserTrackInformation(track)->setSaveFlag(false);
-
-                        ++nKilled_;
-                    } else {
-                        if (verbose_ > 2) {
-                            std::cout << "BeamTrackSelectionPlugin: Track " << track->GetTrackID() << " with PID "
-                                    << track->GetParticleDefinition()->GetPDGEncoding() << " and momentum "
-                                    << track->GetMomentum() << " passed selection" << std::endl;
-                        }
-
-                        // Save this track in output particle coll.
-                        UserTrackInformation::getUserTrackInformation(track)->setSaveFlag(true);
-
-                        ++nPassed_;
-                    }
+
+            G4Track* track = step->GetTrack();
+            if (!passes(track)) {
+                if (verbose_ > 2) {
+                    std::cout << "BeamTrackSelectionPlugin: Track " << track->GetTrackID() << " with PID "
+                            << track->GetParticleDefinition()->GetPDGEncoding() << " and momentum "
+                            << track->GetMomentum() << " failed selection" << std::endl;
                 }
+
+                // Stop and kill the track; let secondaries propagate.
+                step->GetTrack()->SetTrackStatus(G4TrackStatus::fStopAndKill);
+
+                // Do not save this track in output particle coll.
+                UserTrackInformation::getUserTrackInformation(track)->setSaveFlag(false);
+
+                ++nKilled_;
+            } else {
+                if (verbose_ > 2) {
+                    std::cout << "BeamTrackSelectionPlugin: Track " << track->GetTrackID() << " with PID "
+                            << track->GetParticleDefinition()->GetPDGEncoding() << " and momentum "
+                            << track->GetMomentum() << " passed selection" << std::endl;
+                }
+
+                // Save this track in output particle coll.
+                UserTrackInformation::getUserTrackInformation(track)->setSaveFlag(true);
+
+                ++nPassed_;
             }
         }
 
@@ -189,6 +196,9 @@ class BeamTrackSelectionPlugin: public SimPlugin {
         /** Name of target volume in geometry. */
         std::string volumeName_{"target_vol"};
 
+        /** Tag of the target volume. */
+        VolumeTags::Mask targetTag_{0};
+
         /** Number of tracks killed in event. */
         int nKilled_{0};
 
@@ -0,0 +1,157 @@
+/**
+ * @file TimeWindowPlugin.cxx
+ * @brief Class that defines a sim plugin which kills tracks after the readout time window
+ */
+
+// HPS
+#include "ParticleRuleTable.h"
+#include "TimeWindowPlugin.h"
+#include "TimeWindowPluginMessenger.h"
+
+// Geant4
+#include "G4LogicalVolume.hh"
+#include "G4RegionStore.hh"
+#include "G4VPhysicalVolume.hh"
+
+// STL
+#include <algorithm>
+#include <cfloat>
+#include <iostream>
+
+namespace hpssim {
+
+TimeWindowPlugin::TimeWindowPlugin() {
+    messenger_ = new TimeWindowPluginMessenger(this);
+}
+
+TimeWindowPlugin::~TimeWindowPlugin() {
+    delete messenger_;
+}
+
+std::string TimeWindowPlugin::getName() {
+    return "TimeWindowPlugin";
+}
+
+std::vector<SimPlugin::PluginAction> TimeWindowPlugin::getActions() {
+    return {SimPlugin::PluginAction::RUN, SimPlugin::PluginAction::EVENT, SimPlugin::PluginAction::STEPPING,
+            SimPlugin::PluginAction::STACKING};
+}
+
+void TimeWindowPlugin::initialize() {
+    pdgCodes_ = ParticleNames::getPDGCodes(particles_, "TimeWindowPlugin::initialize");
+
+    regionList_.clear();
+    for (auto& name : regions_) {
+        G4Region* region = G4RegionStore::GetInstance()->GetRegion(name, false);
+        if (!region) {
+            G4Exception("TimeWindowPlugin::initialize", "", JustWarning,
+                    G4String("The region '" + name + "' does not exist so it is ignored."));
+            continue;
+        }
+        regionList_.push_back(region);
+    }
+    allRegions_ = regions_.empty();
+}
+
+SimPlugin::SteppingFilter TimeWindowPlugin::getSteppingFilter() {
+    SteppingFilter filter;
+    filter.pdgCodes = pdgCodes_;
+    return filter;
+}
+
+void TimeWindowPlugin::beginRun(const G4Run*) {
+    counts_.clear();
+}
+
+void TimeWindowPlugin::endRun(const G4Run*) {
+    print(std::cout);
+}
+
+void TimeWindowPlugin::beginEvent(const G4Event* anEvent) {
+    double startTime = 0.;
+    if (anEvent->GetNumberOfPrimaryVertex()) {
+        startTime = DBL_MAX;
+        for (int i = 0; i < anEvent->GetNumberOfPrimaryVertex(); i++) {
+            startTime = std::min(startTime, anEvent->GetPrimaryVertex(i)->GetT0());
+        }
+    }
+    endTime_ = startTime + maxTime_;
+}
+
+void TimeWindowPlugin::stepping(const G4Step* aStep) {
+    if (aStep->GetPostStepPoint()->GetGlobalTime() <= endTime_) {
+        return;
+    }
+    if (!inRegions(aStep->GetPreStepPoint()->GetPhysicalVolume())) {
+        return;
+    }
+    G4Track* track = aStep->GetTrack();
+    if (verbose_ > 2) {
+        std::cout << "TimeWindowPlugin: Stopping track " << track->GetTrackID() << " with PID "
+                << track->GetDefinition()->GetPDGEncoding() << " at time " << track->GetGlobalTime() << " ns"
+                << std::endl;
+    }
+    Counts& counts = counts_[track->GetDefinition()->GetPDGEncoding()];
+    ++counts.steppingKilled;
+    counts.killedEnergy += track->GetKineticEnergy();
+
+    // Secondaries from this step are checked when they are classified.
+    track->SetTrackStatus(fStopAndKill);
+}
+
+G4ClassificationOfNewTrack TimeWindowPlugin::stackingClassifyNewTrack(const G4Track* aTrack,
+        const G4ClassificationOfNewTrack& currentTrackClass) {
+    if (currentTrackClass == fKill || aTrack->GetGlobalTime() <= endTime_ || aTrack->GetParentID() == 0) {
+        return currentTrackClass;
+    }
+    int pdgCode = aTrack->GetDefinition()->GetPDGEncoding();
+    if (pdgCodes_.size() && std::find(pdgCodes_.begin(), pdgCodes_.end(), pdgCode) == pdgCodes_.end()) {
+        return currentTrackClass;
+    }
+    if (!inRegions(aTrack->GetVolume())) {
+        return currentTrackClass;
+    }
+    Counts& counts = counts_[pdgCode];
+    ++counts.stackingKilled;
+    counts.killedEnergy += aTrack->GetKineticEnergy();
+    return fKill;
+}
+
+bool TimeWindowPlugin::inRegions(const G4VPhysicalVolume* volume) const {
+    if (allRegions_) {
+        return true;
+    }
+    if (!volume) {
+        return false;
+    }
+    const G4Region* region = volume->GetLogicalVolume()->GetRegion();
+    return std::find(regionList_.begin(), regionList_.end(), region) != regionList_.end();
+}
+
+void TimeWindowPlugin::print(std::ostream& os) {
+    os << "TimeWindowPlugin: Killing tracks after " << maxTime_ << " ns, particles:";
+    for (auto& particle : particles_) {
+        os << " " << particle;
+    }
+    if (particles_.empty()) {
+        os << " any";
+    }
+    os << ", regions:";
+    for (auto& region : regions_) {
+        os << " " << region;
+    }
+    if (regions_.empty()) {
+        os << " any";
+    }
+    os << std::endl;
+    for (auto& entry : counts_) {
+        const Counts& counts = entry.second;
+        os << "  PID " << entry.first << ": " << counts.stackingKilled << " tracks never stacked, "
+                << counts.steppingKilled << " tracks stopped, " << counts.killedEnergy
+                << " MeV kinetic energy not tracked" << std::endl;
+    }
+}
+
+}
+
+SIM_PLUGIN(hpssim, TimeWindowPlugin)
@@ -0,0 +1,188 @@
+/**
+ * @file TimeWindowPlugin.h
+ * @brief Class that defines a sim plugin which kills tracks after the readout time window
+ */
+
+#ifndef HPSSIM_TIMEWINDOWPLUGIN_H_
+#define HPSSIM_TIMEWINDOWPLUGIN_H_
+
+// HPS
+#include "SimPlugin.h"
+
+// Geant4
+#include "G4Region.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4UImessenger.hh"
+
+// STL
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace hpssim {
+
+/**
+ * @class TimeWindowPlugin
+ * @brief Sim plugin which kills tracks whose global time is past the end of the readout window
+ *
+ * @note
+ * The window starts at the earliest primary vertex time of the event.  New tracks created
+ * after the window are never stacked, and tracks are stopped at the first step which ends
+ * after it, so slow neutrons and other long-lived tails are not tracked to the end of their
+ * lifetime.  The cut can be restricted to some particle species and to some regions, where
+ * the region is that of the volume in which the track is created or the step starts.
+ *
+ * @par
+ * The number of tracks killed before being stacked and while being tracked, and their
+ * kinetic energy, are printed at the end of the run by particle species.
+ */
+class TimeWindowPlugin: public SimPlugin {
+
+    public:
+
+        /**
+         * Class constructor.
+         * Creates a messenger for the class.
+         */
+        TimeWindowPlugin();
+
+        /**
+         * Class destructor.
+         * Deletes the messenger for the class.
+         */
+        virtual ~TimeWindowPlugin();
+
+        /**
+         * Get the name of the plugin.
+         */
+        virtual std::string getName();
+
+        /**
+         * Get the actions implemented by this plugin.
+         */
+        std::vector<PluginAction> getActions();
+
+        /**
+         * Resolve the particles and regions of the cut.
+         */
+        void initialize();
+
+        /**
+         * Only steps of the selected particles are passed to the stepping action.
+         */
+        SteppingFilter getSteppingFilter();
+
+        /**
+         * Reset the counters.
+         * @param aRun The current Geant4 run that is starting.
+         */
+        void beginRun(const G4Run* aRun);
+
+        /**
+         * Print the counters.
+         * @param aRun The current Geant4 run that is ending.
+         */
+        void endRun(const G4Run* aRun);
+
+        /**
+         * Set the start of the window from the primary vertices.
+         * @param anEvent The Geant4 event that is starting.
+         */
+        void beginEvent(const G4Event* anEvent);
+
+        /**
+         * Stop a track at the end of the first step after the window.
+         * @param aStep The Geant4 step.
+         */
+        void stepping(const G4Step* aStep);
+
+        /**
+         * Kill a new track which is created after the window.
+         * @param aTrack The new track.
+         * @param currentTrackClass The current track classification.
+         */
+        G4ClassificationOfNewTrack stackingClassifyNewTrack(const G4Track* aTrack,
+                const G4ClassificationOfNewTrack& currentTrackClass);
+
+        /**
+         * Set the length of the window.
+         * @param maxTime The maximum time after the start of the event [ns].
+         */
+        void setMaxTime(double maxTime) {
+            maxTime_ = maxTime;
+        }
+
+        /**
+         * Set the particles the cut applies to.
+         * @param particles Names or PDG codes of the particles (empty for all).
+         */
+        void setParticles(const std::vector<std::string>& particles) {
+            particles_ = particles;
+        }
+
+        /**
+         * Set the regions the cut applies to.
+         * @param regions Names of the regions (empty for all).
+         */
+        void setRegions(const std::vector<std::string>& regions) {
+            regions_ = regions;
+        }
+
+        /**
+         * Print the settings and counters.
+         * @param os The output stream.
+         */
+        void print(std::ostream& os);
+
+    private:
+
+        /**
+         * Counters of the killed tracks of a particle species.
+         */
+        struct Counts {
+                unsigned long stackingKilled{0};
+                unsigned long steppingKilled{0};
+                double killedEnergy{0.};
+        };
+
+        /**
+         * Return true if the cut applies in a volume.
+         */
+        bool inRegions(const G4VPhysicalVolume* volume) const;
+
+    private:
+
+        /**
+         * The messenger for setting plugin parameters.
+         */
+        G4UImessenger* messenger_;
+
+        /** The maximum time after the start of the event [ns]. */
+        double maxTime_{1. * microsecond};
+
+        /** Names or PDG codes of the particles (empty for all). */
+        std::vector<std::string> particles_;
+
+        /** Names of the regions (empty for all). */
+        std::vector<std::string> regions_;
+
+        /** PDG codes of the particles. */
+        std::vector<int> pdgCodes_;
+
+        /** The regions that were found. */
+        std::vector<const G4Region*> regionList_;
+
+        /** True if the cut applies in all regions. */
+        bool allRegions_{true};
+
+        /** The end of the window in the current event. */
+        double endTime_{0.};
+
+        /** Counters by PDG code. */
+        std::map<int, Counts> counts_;
+};
+
+}
+
+#endif
@@ -0,0 +1,67 @@
+#include "TimeWindowPluginMessenger.h"
+
+#include "TimeWindowPlugin.h"
+
+#include <sstream>
+
+namespace hpssim {
+
+TimeWindowPluginMessenger::TimeWindowPluginMessenger(TimeWindowPlugin* plugin) :
+        SimPluginMessenger(plugin), timeWindowPlugin_(plugin) {
+
+    maxTimeCmd_ = new G4UIcmdWithADoubleAndUnit(std::string(getPath() + "maxTime").c_str(), this);
+    maxTimeCmd_->SetGuidance("Set the time after the start of the event when tracks are killed.");
+    maxTimeCmd_->SetParameterName("time", false);
+    maxTimeCmd_->SetDefaultUnit("ns");
+    maxTimeCmd_->AvailableForStates(G4ApplicationState::G4State_PreInit, G4ApplicationState::G4State_Idle);
+
+    particlesCmd_ = new G4UIcmdWithAString(std::string(getPath() + "particles").c_str(), this);
+    particlesCmd_->SetGuidance("Set the particle names or PDG codes the cut applies to, separated by spaces.");
+    particlesCmd_->SetGuidance("An empty list applies the cut to all particles.");
+    particlesCmd_->SetParameterName("particles", true);
+    particlesCmd_->SetDefaultValue("");
+    particlesCmd_->AvailableForStates(G4ApplicationState::G4State_PreInit, G4ApplicationState::G4State_Idle);
+
+    regionsCmd_ = new G4UIcmdWithAString(std::string(getPath() + "regions").c_str(), this);
+    regionsCmd_->SetGuidance("Set the regions the cut applies to, separated by spaces.");
+    regionsCmd_->SetGuidance("An empty list applies the cut in all regions.");
+    regionsCmd_->SetParameterName("regions", true);
+    regionsCmd_->SetDefaultValue("");
+    regionsCmd_->AvailableForStates(G4ApplicationState::G4State_PreInit, G4ApplicationState::G4State_Idle);
+
+    printCmd_ = new G4UIcmdWithoutParameter(std::string(getPath() + "print").c_str(), this);
+    printCmd_->SetGuidance("Print the time window with the number and energy of the killed tracks.");
+}
+
+TimeWindowPluginMessenger::~TimeWindowPluginMessenger() {
+    delete maxTimeCmd_;
+    delete particlesCmd_;
+    delete regionsCmd_;
+    delete printCmd_;
+}
+
+void TimeWindowPluginMessenger::SetNewValue(G4UIcommand *command, G4String newValue) {
+
+    // Handles verbose and parameter commands.
+    SimPluginMessenger::SetNewValue(command, newValue);
+
+    if (command == maxTimeCmd_) {
+        timeWindowPlugin_->setMaxTime(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValue));
+    } else if (command == particlesCmd_ || command == regionsCmd_) {
+        std::istringstream is((const char*) newValue);
+        std::vector<std::string> names;
+        std::string name;
+        while (is >> name) {
+            names.push_back(name);
+        }
+        if (command == particlesCmd_) {
+            timeWindowPlugin_->setParticles(names);
+        } else {
+            timeWindowPlugin_->setRegions(names);
+        }
+    } else if (command == printCmd_) {
+        timeWindowPlugin_->print(std::cout);
+    }
+}
+
+} // namespace hpssim
@@ -0,0 +1,81 @@
+/**
+ * @file TimeWindowPluginMessenger.h
+ * @brief Class that defines a macro messenger for a TimeWindowPlugin
+ */
+
+#ifndef HPSSIM_TIMEWINDOWPLUGINMESSENGER_H_
+#define HPSSIM_TIMEWINDOWPLUGINMESSENGER_H_
+
+// HPS
+#include "SimPluginMessenger.h"
+
+// Geant4
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithoutParameter.hh"
+
+namespace hpssim {
+
+/*
+ * Declare the plugin class because there is a circular dep between
+ * the plugin its messenger class.
+ */
+class TimeWindowPlugin;
+
+/**
+ * @class TimeWindowPluginMessenger
+ * @brief Messenger class for setting the time window of the TimeWindowPlugin
+ */
+class TimeWindowPluginMessenger: public SimPluginMessenger {
+
+    public:
+
+        /**
+         * Class constructor.
+         * @param plugin The associated TimeWindowPlugin object.
+         */
+        TimeWindowPluginMessenger(TimeWindowPlugin* plugin);
+
+        /**
+         * Class destructor.
+         */
+        virtual ~TimeWindowPluginMessenger();
+
+        /**
+         * Process the macro command.
+         * @param command The macro command.
+         * @param newValue The argument values.
+         */
+        void SetNewValue(G4UIcommand *command, G4String newValue);
+
+    private:
+
+        /**
+         * The associated user plugin.
+         */
+        TimeWindowPlugin* timeWindowPlugin_;
+
+        /**
+         * Command for setting the length of the window.
+         */
+        G4UIcmdWithADoubleAndUnit* maxTimeCmd_;
+
+        /**
+         * Command for setting the particles the cut applies to.
+         */
+        G4UIcmdWithAString* particlesCmd_;
+
+        /**
+         * Command for setting the regions the cut applies to.
+         */
+        G4UIcmdWithAString* regionsCmd_;
+
+        /**
+         * Command for printing the settings and counters.
+         */
+        G4UIcmdWithoutParameter* printCmd_;
+};
+
+} // namespace hpssim
+
+#endif
@@ -0,0 +1,156 @@
+/**
+ * @file TrackKillerPlugin.cxx
+ * @brief Class that defines a sim plugin which kills new tracks below energy thresholds
+ */
+
+// HPS
+#include "TrackKillerPlugin.h"
+#include "TrackKillerPluginMessenger.h"
+
+// Geant4
+#include "G4LogicalVolume.hh"
+#include "G4RegionStore.hh"
+#include "G4VPhysicalVolume.hh"
+
+// STL
+#include <iostream>
+
+namespace hpssim {
+
+TrackKillerPlugin::TrackKillerPlugin() {
+    messenger_ = new TrackKillerPluginMessenger(this);
+}
+
+TrackKillerPlugin::~TrackKillerPlugin() {
+    delete messenger_;
+}
+
+std::string TrackKillerPlugin::getName() {
+    return "TrackKillerPlugin";
+}
+
+std::vector<SimPlugin::PluginAction> TrackKillerPlugin::getActions() {
+    return {SimPlugin::PluginAction::RUN, SimPlugin::PluginAction::STACKING};
+}
+
+void TrackKillerPlugin::beginRun(const G4Run*) {
+    for (auto& rule : rules_) {
+        rule.killed = 0;
+        rule.killedEnergy = 0.;
+    }
+    compile();
+    if (verbose_ > 1) {
+        print(std::cout);
+    }
+}
+
+void TrackKillerPlugin::endRun(const G4Run*) {
+    print(std::cout);
+}
+
+G4ClassificationOfNewTrack TrackKillerPlugin::stackingClassifyNewTrack(const G4Track* aTrack,
+        const G4ClassificationOfNewTrack& currentTrackClass) {
+    if (currentTrackClass == fKill || aTrack->GetParentID() == 0) {
+        return currentTrackClass;
+    }
+
+    const std::vector<CompiledRule*>& candidates = table_.getCandidates(aTrack->GetDefinition()->GetPDGEncoding());
+    if (candidates.empty()) {
+        return currentTrackClass;
+    }
+
+    // New secondaries are in the volume of the step which created them.
+    const G4VPhysicalVolume* volume = aTrack->GetVolume();
+    const G4LogicalVolume* logicalVolume = volume ? volume->GetLogicalVolume() : nullptr;
+    for (auto compiledRule : candidates) {
+        if (compiledRule->region && (!logicalVolume || logicalVolume->GetRegion() != compiledRule->region)) {
+            continue;
+        }
+        if (compiledRule->volumeTag) {
+            VolumeTags* tags = VolumeTags::getVolumeTags();
+            if (!tags->hasTag(volume, compiledRule->volumeTag) && !tags->hasTag(logicalVolume, compiledRule->volumeTag)) {
+                continue;
+            }
+        }
+        Rule* rule = compiledRule->rule;
+        double energy = aTrack->GetKineticEnergy();
+        if (energy >= rule->threshold) {
+            return currentTrackClass;
+        }
+        if (verbose_ > 2) {
+            std::cout << "TrackKillerPlugin: Killing track " << aTrack->GetTrackID() << " with PID "
+                    << aTrack->GetDefinition()->GetPDGEncoding() << " and kinetic energy " << energy << " MeV"
+                    << std::endl;
+        }
+        ++rule->killed;
+        rule->killedEnergy += energy;
+        return fKill;
+    }
+    return currentTrackClass;
+}
+
+void TrackKillerPlugin::addRule(double threshold) {
+    rules_.push_back(Rule());
+    rules_.back().threshold = threshold;
+    compiled_.clear();
+    table_.clear();
+}
+
+TrackKillerPlugin::Rule* TrackKillerPlugin::getLastRule() {
+    return rules_.size() ? &rules_.back() : nullptr;
+}
+
+void TrackKillerPlugin::clear() {
+    rules_.clear();
+    compiled_.clear();
+    table_.clear();
+}
+
+void TrackKillerPlugin::compile() {
+    compiled_.clear();
+    table_.clear();
+    compiled_.reserve(rules_.size());
+    for (auto& rule : rules_) {
+        CompiledRule compiledRule;
+        compiledRule.rule = &rule;
+        if (rule.region.size()) {
+            compiledRule.region = G4RegionStore::GetInstance()->GetRegion(rule.region, false);
+            if (!compiledRule.region) {
+                G4Exception("TrackKillerPlugin::compile", "", JustWarning,
+                        G4String("The region '" + rule.region + "' does not exist so its rule is ignored."));
+                continue;
+            }
+        }
+        if (rule.volumeTag.size()) {
+            compiledRule.volumeTag = VolumeTags::getVolumeTags()->findTag(rule.volumeTag);
+            if (!compiledRule.volumeTag) {
+                G4Exception("TrackKillerPlugin::compile", "", JustWarning,
+                        G4String("The volume tag '" + rule.volumeTag + "' does not exist so its rule is ignored."));
+                continue;
+            }
+        }
+        std::vector<int> pdgCodes = ParticleNames::getPDGCodes(rule.particles, "TrackKillerPlugin::compile");
+        compiled_.push_back(compiledRule);
+        table_.add(&compiled_.back(), pdgCodes);
+    }
+}
+
+void TrackKillerPlugin::print(std::ostream& os) {
+    os << "TrackKillerPlugin: " << rules_.size() << " rules" << std::endl;
+    for (auto& rule : rules_) {
+        os << "  kill below " << rule.threshold << " MeV, particles:";
+        for (auto& particle : rule.particles) {
+            os << " " << particle;
+        }
+        if (rule.particles.empty()) {
+            os << " any";
+        }
+        os << ", region: " << (rule.region.size() ? rule.region : "any") << ", volume tag: "
+                << (rule.volumeTag.size() ? rule.volumeTag : "any") << ", killed: " << rule.killed
+                << " tracks with " << rule.killedEnergy << " MeV" << std::endl;
+    }
+}
+
+}
+
+SIM_PLUGIN(hpssim, TrackKillerPlugin)
@@ -0,0 +1,169 @@
+/**
+ * @file TrackKillerPlugin.h
+ * @brief Class that defines a sim plugin which kills new tracks below energy thresholds
+ */
+
+#ifndef HPSSIM_TRACKKILLERPLUGIN_H_
+#define HPSSIM_TRACKKILLERPLUGIN_H_
+
+// HPS
+#include "ParticleRuleTable.h"
+#include "SimPlugin.h"
+#include "VolumeTags.h"
+
+// Geant4
+#include "G4Region.hh"
+#include "G4UImessenger.hh"
+
+// STL
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace hpssim {
+
+/**
+ * @class TrackKillerPlugin
+ * @brief Sim plugin which kills new tracks below kinetic energy thresholds by particle and location
+ *
+ * @note
+ * A rule kills tracks of its particles whose kinetic energy is below its threshold when they
+ * are created in its region or in a volume with its tag.  Conditions which are not set match
+ * any track, and the first rule which matches the particle and location of a track decides,
+ * so rules for specific regions should be added before general ones.  Tracks are killed when
+ * they are classified on the stack, so they are never simulated or stored.  Primaries are
+ * never killed.
+ *
+ * @par
+ * The number of killed tracks and their total kinetic energy are counted for each rule and
+ * printed at the end of the run.
+ */
+class TrackKillerPlugin: public SimPlugin {
+
+    public:
+
+        /**
+         * A killing rule with its counters.
+         */
+        struct Rule {
+
+                /** Kinetic energy threshold [MeV]. */
+                double threshold{0.};
+
+                /** Names or PDG codes of the particles (empty for any). */
+                std::vector<std::string> particles;
+
+                /** Name of the region where the track is created (empty for any). */
+                std::string region;
+
+                /** Name of the volume tag where the track is created (empty for any). */
+                std::string volumeTag;
+
+                /** Number of killed tracks. */
+                unsigned long killed{0};
+
+                /** Total kinetic energy of the killed tracks [MeV]. */
+                double killedEnergy{0.};
+        };
+
+        /**
+         * Class constructor.
+         * Creates a messenger for the class.
+         */
+        TrackKillerPlugin();
+
+        /**
+         * Class destructor.
+         * Deletes the messenger for the class.
+         */
+        virtual ~TrackKillerPlugin();
+
+        /**
+         * Get the name of the plugin.
+         */
+        virtual std::string getName();
+
+        /**
+         * Get the actions implemented by this plugin.
+         */
+        std::vector<PluginAction> getActions();
+
+        /**
+         * Compile the rules and reset their counters.
+         * @param aRun The current Geant4 run that is starting.
+         */
+        void beginRun(const G4Run* aRun);
+
+        /**
+         * Print the counters of the rules.
+         * @param aRun The current Geant4 run that is ending.
+         */
+        void endRun(const G4Run* aRun);
+
+        /**
+         * Kill a new track if it matches a rule and is below its threshold.
+         * @param aTrack The new track.
+         * @param currentTrackClass The current track classification.
+         */
+        G4ClassificationOfNewTrack stackingClassifyNewTrack(const G4Track* aTrack,
+                const G4ClassificationOfNewTrack& currentTrackClass);
+
+        /**
+         * Add a rule after the existing ones.
+         * @param threshold The kinetic energy threshold [MeV].
+         */
+        void addRule(double threshold);
+
+        /**
+         * Get the last rule for setting its conditions.
+         * @return The last rule or null if there are no rules.
+         */
+        Rule* getLastRule();
+
+        /**
+         * Remove all rules.
+         */
+        void clear();
+
+        /**
+         * Print the rules and their counters.
+         * @param os The output stream.
+         */
+        void print(std::ostream& os);
+
+    private:
+
+        /**
+         * A rule with its region, volume tag and particles resolved.
+         */
+        struct CompiledRule {
+                Rule* rule{nullptr};
+                const G4Region* region{nullptr};
+                VolumeTags::Mask volumeTag{0};
+        };
+
+        /**
+         * Compile the rules into the table of candidate rules by particle species.
+         */
+        void compile();
+
+    private:
+
+        /**
+         * The messenger for setting plugin parameters.
+         */
+        G4UImessenger* messenger_;
+
+        /** The rules in the order they were added. */
+        std::vector<Rule> rules_;
+
+        /** The valid compiled rules in the same order. */
+        std::vector<CompiledRule> compiled_;
+
+        /** Candidate rules by particle species. */
+        ParticleRuleTable<CompiledRule> table_;
+};
+
+}
+
+#endif
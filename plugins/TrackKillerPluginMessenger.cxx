@@ -0,0 +1,89 @@
+#include "TrackKillerPluginMessenger.h"
+
+#include "TrackKillerPlugin.h"
+
+#include <sstream>
+
+namespace hpssim {
+
+TrackKillerPluginMessenger::TrackKillerPluginMessenger(TrackKillerPlugin* plugin) :
+        SimPluginMessenger(plugin), trackKillerPlugin_(plugin) {
+
+    addCmd_ = new G4UIcmdWithADoubleAndUnit(std::string(getPath() + "add").c_str(), this);
+    addCmd_->SetGuidance("Add a rule which kills new tracks below a kinetic energy threshold.");
+    addCmd_->SetGuidance("The conditions of the rule are set by the commands which follow.");
+    addCmd_->SetParameterName("threshold", false);
+    addCmd_->SetDefaultUnit("MeV");
+    addCmd_->AvailableForStates(G4ApplicationState::G4State_PreInit, G4ApplicationState::G4State_Idle);
+
+    particlesCmd_ = new G4UIcmdWithAString(std::string(getPath() + "particles").c_str(), this);
+    particlesCmd_->SetGuidance("Set the particle names or PDG codes of the last rule, separated by spaces.");
+    particlesCmd_->SetParameterName("particles", false);
+    particlesCmd_->AvailableForStates(G4ApplicationState::G4State_PreInit, G4ApplicationState::G4State_Idle);
+
+    regionCmd_ = new G4UIcmdWithAString(std::string(getPath() + "region").c_str(), this);
+    regionCmd_->SetGuidance("Set the region where tracks are created of the last rule.");
+    regionCmd_->SetParameterName("region", false);
+    regionCmd_->AvailableForStates(G4ApplicationState::G4State_PreInit, G4ApplicationState::G4State_Idle);
+
+    volumeTagCmd_ = new G4UIcmdWithAString(std::string(getPath() + "volumeTag").c_str(), this);
+    volumeTagCmd_->SetGuidance("Set the tag of the volumes where tracks are created of the last rule.");
+    volumeTagCmd_->SetGuidance("Tags are defined with /hps/volumes/tag.");
+    volumeTagCmd_->SetParameterName("tag", false);
+    volumeTagCmd_->AvailableForStates(G4ApplicationState::G4State_PreInit, G4ApplicationState::G4State_Idle);
+
+    clearCmd_ = new G4UIcmdWithoutParameter(std::string(getPath() + "clear").c_str(), this);
+    clearCmd_->SetGuidance("Remove all killing rules.");
+    clearCmd_->AvailableForStates(G4ApplicationState::G4State_PreInit, G4ApplicationState::G4State_Idle);
+
+    printCmd_ = new G4UIcmdWithoutParameter(std::string(getPath() + "print").c_str(), this);
+    printCmd_->SetGuidance("Print the killing rules with the number and energy of the tracks they killed.");
+}
+
+TrackKillerPluginMessenger::~TrackKillerPluginMessenger() {
+    delete addCmd_;
+    delete particlesCmd_;
+    delete regionCmd_;
+    delete volumeTagCmd_;
+    delete clearCmd_;
+    delete printCmd_;
+}
+
+void TrackKillerPluginMessenger::SetNewValue(G4UIcommand *command, G4String newValue) {
+
+    // Handles verbose and parameter commands.
+    SimPluginMessenger::SetNewValue(command, newValue);
+
+    if (command == addCmd_) {
+        trackKillerPlugin_->addRule(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValue));
+        return;
+    } else if (command == clearCmd_) {
+        trackKillerPlugin_->clear();
+        return;
+    } else if (command == printCmd_) {
+        trackKillerPlugin_->print(std::cout);
+        return;
+    } else if (command != particlesCmd_ && command != regionCmd_ && command != volumeTagCmd_) {
+        return;
+    }
+
+    TrackKillerPlugin::Rule* rule = trackKillerPlugin_->getLastRule();
+    if (!rule) {
+        G4Exception("TrackKillerPluginMessenger::SetNewValue", "", FatalException,
+                "A killing rule must be added before setting its conditions.");
+    }
+    if (command == particlesCmd_) {
+        std::istringstream is((const char*) newValue);
+        std::string particle;
+        rule->particles.clear();
+        while (is >> particle) {
+            rule->particles.push_back(particle);
+        }
+    } else if (command == regionCmd_) {
+        rule->region = newValue;
+    } else if (command == volumeTagCmd_) {
+        rule->volumeTag = newValue;
+    }
+}
+
+} // namespace hpssim
@@ -0,0 +1,91 @@
+/**
+ * @file TrackKillerPluginMessenger.h
+ * @brief Class that defines a macro messenger for a TrackKillerPlugin
+ */
+
+#ifndef HPSSIM_TRACKKILLERPLUGINMESSENGER_H_
+#define HPSSIM_TRACKKILLERPLUGINMESSENGER_H_
+
+// HPS
+#include "SimPluginMessenger.h"
+
+// Geant4
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithoutParameter.hh"
+
+namespace hpssim {
+
+/*
+ * Declare the plugin class because there is a circular dep between
+ * the plugin its messenger class.
+ */
+class TrackKillerPlugin;
+
+/**
+ * @class TrackKillerPluginMessenger
+ * @brief Messenger class for defining the killing rules of the TrackKillerPlugin
+ */
+class TrackKillerPluginMessenger: public SimPluginMessenger {
+
+    public:
+
+        /**
+         * Class constructor.
+         * @param plugin The associated TrackKillerPlugin object.
+         */
+        TrackKillerPluginMessenger(TrackKillerPlugin* plugin);
+
+        /**
+         * Class destructor.
+         */
+        virtual ~TrackKillerPluginMessenger();
+
+        /**
+         * Process the macro command.
+         * @param command The macro command.
+         * @param newValue The argument values.
+         */
+        void SetNewValue(G4UIcommand *command, G4String newValue);
+
+    private:
+
+        /**
+         * The associated user plugin.
+         */
+        TrackKillerPlugin* trackKillerPlugin_;
+
+        /**
+         * Command for adding a rule with its energy threshold.
+         */
+        G4UIcmdWithADoubleAndUnit* addCmd_;
+
+        /**
+         * Command for setting the particles of the last rule.
+         */
+        G4UIcmdWithAString* particlesCmd_;
+
+        /**
+         * Command for setting the region of the last rule.
+         */
+        G4UIcmdWithAString* regionCmd_;
+
+        /**
+         * Command for setting the volume tag of the last rule.
+         */
+        G4UIcmdWithAString* volumeTagCmd_;
+
+        /**
+         * Command for removing all rules.
+         */
+        G4UIcmdWithoutParameter* clearCmd_;
+
+        /**
+         * Command for printing the rules and their counters.
+         */
+        G4UIcmdWithoutParameter* printCmd_;
+};
+
+} // namespace hpssim
+
+#endif
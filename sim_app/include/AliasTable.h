@@ -0,0 +1,126 @@
+#ifndef HPSSIM_ALIASTABLE_H_
+#define HPSSIM_ALIASTABLE_H_
+
+#include <cmath>
+#include <vector>
+
+namespace hpssim {
+
+/**
+ * @class AliasTable
+ * @brief Walker alias table for sampling indices in proportion to their weights in constant time
+ *
+ * @note
+ * The table is built with Vose's method.  Negative weights are sampled in proportion
+ * to their absolute value, so the caller should carry the sign of the sampled weight
+ * on the output event.
+ */
+class AliasTable {
+
+    public:
+
+        /**
+         * Build the table from a list of weights.
+         * @return False if there are no weights or they are all zero.
+         */
+        bool build(const std::vector<double>& weights) {
+
+            unsigned n = weights.size();
+            prob_.assign(n, 1.);
+            alias_.resize(n);
+            for (unsigned i = 0; i < n; i++) {
+                alias_[i] = i;
+            }
+
+            double sum = 0.;
+            for (auto weight : weights) {
+                sum += std::fabs(weight);
+            }
+            meanWeight_ = n ? sum / n : 0.;
+            if (sum <= 0.) {
+                return false;
+            }
+
+            // Split the scaled weights into entries below and above the mean.
+            std::vector<double> scaled(n);
+            std::vector<unsigned> small, large;
+            for (unsigned i = 0; i < n; i++) {
+                scaled[i] = std::fabs(weights[i]) * n / sum;
+                if (scaled[i] < 1.) {
+                    small.push_back(i);
+                } else {
+                    large.push_back(i);
+                }
+            }
+
+            // Fill each small entry up to the mean from a large entry.
+            while (!small.empty() && !large.empty()) {
+                unsigned s = small.back();
+                small.pop_back();
+                unsigned l = large.back();
+                large.pop_back();
+                prob_[s] = scaled[s];
+                alias_[s] = l;
+                scaled[l] = (scaled[l] + scaled[s]) - 1.;
+                if (scaled[l] < 1.) {
+                    small.push_back(l);
+                } else {
+                    large.push_back(l);
+                }
+            }
+
+            // Whatever is left is equal to the mean up to rounding errors.
+            for (auto i : large) {
+                prob_[i] = 1.;
+            }
+            for (auto i : small) {
+                prob_[i] = 1.;
+            }
+
+            return true;
+        }
+
+        /**
+         * Sample an index using a uniform random number in [0, 1).
+         */
+        unsigned sample(double u) const {
+            double x = u * prob_.size();
+            unsigned i = x;
+            if (i >= prob_.size()) {
+                i = prob_.size() - 1;
+            }
+            return (x - i) < prob_[i] ? i : alias_[i];
+        }
+
+        /**
+         * Get the mean of the absolute weights.
+         */
+        double getMeanWeight() const {
+            return meanWeight_;
+        }
+
+        unsigned size() const {
+            return prob_.size();
+        }
+
+        void clear() {
+            prob_.clear();
+            alias_.clear();
+            meanWeight_ = 0.;
+        }
+
+    private:
+
+        /** Probability of keeping each index instead of taking its alias. */
+        std::vector<double> prob_;
+
+        /** Alias of each index. */
+        std::vector<unsigned> alias_;
+
+        /** Mean absolute weight. */
+        double meanWeight_{0.};
+};
+
+}
+
+#endif
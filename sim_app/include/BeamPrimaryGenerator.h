@@ -2,11 +2,14 @@
 #include "G4SystemOfUnits.hh"
 
 #include "CLHEP/Random/RandGauss.h"
+#include "CLHEP/Units/PhysicalConstants.h"
 
 #include "PrimaryGenerator.h"
 #include "UserPrimaryParticleInformation.h"
 
+#include <cmath>
 #include <math.h>
+#include <vector>
 
 namespace hpssim {
 
@@ -30,6 +33,7 @@ namespace hpssim {
  * <li>Number of electrons can be explicitly set to override the calculated value.</li>
  * <li>Gaussian smearing is applied to the number of electrons, if it is not overridden via a parameter.</li>
  * <li>Vertex X and Y positions are smeared according to the beam's transverse profile.</li>
+ * <li>The vertex positions of a bunch are sampled in one batch, and the electrons are copied from a single template primary.</li>
  * <li>Rotation into beam coordinates is automatically applied using the RotateTransform.</li>
  * <li>Particle direction is (0,0,1) before rotation.
  * <li>Origin of beam particles is currently hard-coded to 10 mm upstream of the target at (0,0,0).
@@ -42,6 +46,8 @@ class BeamPrimaryGenerator : public PrimaryGenerator {
 
         BeamPrimaryGenerator(std::string name);
 
+        virtual ~BeamPrimaryGenerator();
+
         void GeneratePrimaryVertex(G4Event* anEvent);
 
         void initialize();
@@ -50,6 +56,11 @@ class BeamPrimaryGenerator : public PrimaryGenerator {
 
         void computeNumberOfElectrons();
 
+        /**
+         * Sample the X and Y vertex positions of a bunch of electrons in one batch.
+         */
+        void sampleBunch(int nElectrons);
+
     private:
 
         /** Vertex position of the beam particles. */
@@ -75,6 +86,21 @@ class BeamPrimaryGenerator : public PrimaryGenerator {
 
         /** Flag for Gaussian smearing of number of electrons. */
         bool smearNElectrons_{false};
+
+        /** Flag set once the rotation into beam coordinates was added to the transforms. */
+        bool rotateAdded_{false};
+
+        /** Primary which is copied for every beam electron, as they only differ by vertex position. */
+        G4PrimaryParticle* electron_{nullptr};
+
+        /** Uniform random numbers for sampling the bunch. */
+        std::vector<double> flat_;
+
+        /** Sampled vertex X positions of the bunch. */
+        std::vector<double> vertexX_;
+
+        /** Sampled vertex Y positions of the bunch. */
+        std::vector<double> vertexY_;
 };
 
 }
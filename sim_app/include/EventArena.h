@@ -0,0 +1,175 @@
+/**
+ * @file EventArena.h
+ * @brief Class providing a per-event memory arena for track bookkeeping objects
+ */
+
+#ifndef HPSSIM_EVENTARENA_H_
+#define HPSSIM_EVENTARENA_H_
+
+#include "MemoryBudget.h"
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace hpssim {
+
+/**
+ * @class EventArena
+ * @brief Monotonic memory arena for objects that live for one event, such as the
+ * track information, trajectories and trajectory points
+ *
+ * @note
+ * Memory is taken from large blocks by bumping an offset, and freeing an object only
+ * decrements the count of live objects of the epoch it was allocated in.  A new epoch
+ * is started at the beginning of every event.  The blocks of an epoch are reused in bulk
+ * once all of its objects are freed, which is normally when the previous event is deleted.
+ * Events that are kept longer, e.g. for visualization, only delay the reuse of their blocks.
+ */
+class EventArena {
+
+    public:
+
+        static EventArena* getArena() {
+            static EventArena theInstance;
+            return &theInstance;
+        }
+
+        /**
+         * Allocate memory for an object in the current epoch.
+         */
+        void* allocate(size_t size) {
+            size_t total = HEADER_SIZE + align(size);
+            if (total > BLOCK_SIZE) {
+                // Too big for a block so allocate it separately.
+                char* mem = static_cast<char*>(::operator new(total));
+                *reinterpret_cast<Epoch**>(mem) = nullptr;
+                return mem + HEADER_SIZE;
+            }
+            if (!block_ || offset_ + total > BLOCK_SIZE) {
+                nextBlock();
+            }
+            char* mem = block_ + offset_;
+            offset_ += total;
+            *reinterpret_cast<Epoch**>(mem) = epoch_;
+            ++epoch_->live;
+            return mem + HEADER_SIZE;
+        }
+
+        /**
+         * Free an object allocated from the arena.
+         */
+        static void deallocate(void* ptr) {
+            if (!ptr) {
+                return;
+            }
+            char* mem = static_cast<char*>(ptr) - HEADER_SIZE;
+            Epoch* epoch = *reinterpret_cast<Epoch**>(mem);
+            if (!epoch) {
+                ::operator delete(mem);
+                return;
+            }
+            if (--epoch->live == 0 && epoch->closed) {
+                getArena()->recycle(epoch);
+            }
+        }
+
+        /**
+         * Start a new epoch for the objects of the next event.
+         */
+        void beginEvent() {
+            if (epoch_->live == 0) {
+                // All objects of the last event are gone so its blocks can be reused right away.
+                freeBlocks_.insert(freeBlocks_.end(), epoch_->blocks.begin(), epoch_->blocks.end());
+                epoch_->blocks.clear();
+            } else {
+                epoch_->closed = true;
+                epoch_ = new Epoch;
+            }
+            block_ = nullptr;
+            offset_ = 0;
+        }
+
+        /**
+         * Get the number of blocks which have been allocated.
+         */
+        size_t getNumberOfBlocks() const {
+            return nBlocks_;
+        }
+
+    private:
+
+        /**
+         * The blocks of an event and the count of its objects which are still alive.
+         */
+        struct Epoch {
+            std::vector<char*> blocks;
+            size_t live{0};
+            bool closed{false};
+        };
+
+        /** Size of the blocks objects are allocated from. */
+        static const size_t BLOCK_SIZE = 1 << 20;
+
+        /** Size of the header with the epoch of an object, which keeps the object aligned. */
+        static const size_t HEADER_SIZE = alignof(std::max_align_t);
+
+        static size_t align(size_t size) {
+            return (size + HEADER_SIZE - 1) / HEADER_SIZE * HEADER_SIZE;
+        }
+
+        EventArena() {
+            epoch_ = new Epoch;
+        }
+
+        ~EventArena() {
+            for (auto block : freeBlocks_) {
+                delete[] block;
+            }
+            if (epoch_->live == 0) {
+                for (auto block : epoch_->blocks) {
+                    delete[] block;
+                }
+                delete epoch_;
+            }
+        }
+
+        void nextBlock() {
+            if (freeBlocks_.size()) {
+                block_ = freeBlocks_.back();
+                freeBlocks_.pop_back();
+            } else {
+                block_ = new char[BLOCK_SIZE];
+                ++nBlocks_;
+                MemoryBudget::getBudget()->setUsage("EventArena", nBlocks_ * BLOCK_SIZE);
+            }
+            epoch_->blocks.push_back(block_);
+            offset_ = 0;
+        }
+
+        void recycle(Epoch* epoch) {
+            freeBlocks_.insert(freeBlocks_.end(), epoch->blocks.begin(), epoch->blocks.end());
+            delete epoch;
+        }
+
+    private:
+
+        /** The epoch of the current event. */
+        Epoch* epoch_;
+
+        /** The block objects are currently allocated from. */
+        char* block_{nullptr};
+
+        /** Offset of the free memory in the current block. */
+        size_t offset_{0};
+
+        /** Blocks which are not used by any epoch. */
+        std::vector<char*> freeBlocks_;
+
+        /** Total number of blocks allocated. */
+        size_t nBlocks_{0};
+};
+
+}
+
+#endif
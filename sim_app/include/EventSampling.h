@@ -4,6 +4,8 @@
 #include "G4Event.hh"
 #include "G4Poisson.hh"
 
+#include <random>
+
 namespace hpssim {
 
 /**
@@ -23,6 +25,12 @@ class EventSampling {
          */
         virtual int getNumberOfEvents(G4Event* event) = 0;
 
+        /**
+         * Get the number of events to sample for an event ID using the given random engine.
+         * This is used to plan the sampling for a whole run from a separate, reproducible stream.
+         */
+        virtual int getNumberOfEvents(int eventID, std::mt19937& engine) = 0;
+
         /**
          * Set the double param value.
          */
@@ -52,6 +60,10 @@ class UniformEventSampling : public EventSampling {
         int getNumberOfEvents(G4Event*) {
             return param_;
         }
+
+        int getNumberOfEvents(int, std::mt19937&) {
+            return param_;
+        }
 };
 
 /**
@@ -66,6 +78,14 @@ class PoissonEventSampling : public EventSampling {
             double nevents = G4Poisson(param_);
             return nevents;
         }
+
+        int getNumberOfEvents(int, std::mt19937& engine) {
+            if (param_ <= 0.) {
+                return 0;
+            }
+            std::poisson_distribution<int> poisson(param_);
+            return poisson(engine);
+        }
 };
 
 /**
@@ -77,11 +97,21 @@ class PeriodicEventSampling : public EventSampling {
     public:
 
         int getNumberOfEvents(G4Event* anEvent) {
-            if (anEvent->GetEventID() % (int)param_ == 0) {
+            return getNumberOfEvents(anEvent->GetEventID());
+        }
+
+        int getNumberOfEvents(int eventID, std::mt19937&) {
+            return getNumberOfEvents(eventID);
+        }
+
+    private:
+
+        int getNumberOfEvents(int eventID) {
+            if (eventID % (int)param_ == 0) {
                 return 1;
-            } else { 
+            } else {
                 return 0;
-            }    
+            }
         }
 
 };
@@ -0,0 +1,196 @@
+/**
+ * @file GeneratorCacheRegistry.h
+ * @brief Process-wide registry of parsed generator event caches
+ */
+
+#ifndef HPSSIM_GENERATORCACHEREGISTRY_H_
+#define HPSSIM_GENERATORCACHEREGISTRY_H_
+
+#include "MemoryBudget.h"
+#include "SharedCacheFile.h"
+
+#include <sys/stat.h>
+
+#include <climits>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+namespace hpssim {
+
+/**
+ * @class GeneratorCacheRegistry
+ * @brief Shares the immutable event caches of generators which read the same file
+ *
+ * @note
+ * Caches are keyed by the cache type, the canonical file path with its modification time
+ * and size, and a variant string for anything else that changes the cached data, such as
+ * the layout or the fingerprint of the transforms applied to it.  The registry only holds
+ * weak references, so a cache is freed when the last generator using it moves on to its
+ * next file.  Generators keep their own event lists and cursors into the shared cache.
+ *
+ * @par
+ * If a shared memory directory is set, caches which support it are also published to
+ * other processes on the same host through a SharedCacheFile in that directory.
+ */
+class GeneratorCacheRegistry {
+
+    public:
+
+        static GeneratorCacheRegistry* getRegistry() {
+            static GeneratorCacheRegistry theInstance;
+            return &theInstance;
+        }
+
+        /**
+         * Make the key of a cache.
+         * @param type The type of the cache.
+         * @param file The input file of the cache.
+         * @param variant Extra data that changes the contents of the cache.
+         */
+        static std::string makeKey(const std::string& type, const std::string& file, const std::string& variant = "") {
+            std::ostringstream key;
+            key << type << ':';
+            char path[PATH_MAX];
+            if (realpath(file.c_str(), path)) {
+                key << path;
+            } else {
+                key << file;
+            }
+            struct stat info;
+            if (!stat(file.c_str(), &info)) {
+                key << ':' << info.st_mtime << ':' << info.st_size;
+            }
+            key << ':' << variant;
+            return key.str();
+        }
+
+        /**
+         * Find a cache by its key.
+         * @return The cache or null if it does not exist or was already freed.
+         */
+        template<class T>
+        std::shared_ptr<const T> find(const std::string& key) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = caches_.find(key);
+            if (it == caches_.end()) {
+                return nullptr;
+            }
+            auto cache = it->second.lock();
+            if (!cache) {
+                caches_.erase(it);
+                return nullptr;
+            }
+            if (verbose_ > 1) {
+                std::cout << "GeneratorCacheRegistry: Sharing cache '" << key << "'" << std::endl;
+            }
+            return std::static_pointer_cast<const T>(cache);
+        }
+
+        /**
+         * Register a cache so other generators can share it.
+         * The cache must not be modified after it is added.
+         */
+        template<class T>
+        void add(const std::string& key, std::shared_ptr<const T> cache) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto it = caches_.begin(); it != caches_.end();) {
+                if (it->second.expired()) {
+                    it = caches_.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            caches_[key] = cache;
+            if (verbose_ > 1) {
+                std::cout << "GeneratorCacheRegistry: Added cache '" << key << "'" << std::endl;
+            }
+        }
+
+        /**
+         * Set the directory for caches shared between processes, e.g. /dev/shm or a hugetlbfs
+         * mount point.  An empty directory disables sharing caches between processes.
+         */
+        void setSharedMemoryDir(const std::string& dir) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            sharedMemoryDir_ = dir;
+        }
+
+        /**
+         * Open the shared memory file of a cache.
+         * @return The file or null if shared memory caches are disabled or the file cannot be used.
+         */
+        std::shared_ptr<SharedCacheFile> openSharedFile(const std::string& key) {
+            std::string dir;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                dir = sharedMemoryDir_;
+            }
+            if (dir.empty()) {
+                return nullptr;
+            }
+            auto file = SharedCacheFile::open(dir, key);
+            if (file && verbose_ > 1) {
+                std::cout << "GeneratorCacheRegistry: " << (file->isComplete() ? "Attached to" : "Building")
+                        << " shared memory cache '" << file->getPath() << "'" << std::endl;
+            }
+            return file;
+        }
+
+        /**
+         * Pack a cache into an incomplete shared memory file and publish it.
+         * @return A cache mapped to the file, or the original cache if the file could not be allocated.
+         */
+        template<class T>
+        static std::shared_ptr<T> publish(std::shared_ptr<SharedCacheFile> file, std::shared_ptr<T> cache) {
+            char* data = file->allocate(cache->pack(nullptr));
+            if (!data) {
+                return cache;
+            }
+            cache->pack(data);
+            file->publish();
+            auto mapped = std::make_shared<T>();
+            mapped->map(file);
+            return mapped;
+        }
+
+        /**
+         * Account for the memory of a cache in the MemoryBudget for as long as the cache exists.
+         * @return A pointer to the cache which releases the memory from the budget when it is deleted.
+         */
+        template<class T>
+        static std::shared_ptr<T> account(const std::string& name, std::shared_ptr<T> cache, size_t bytes) {
+            MemoryBudget::getBudget()->setUsage(name, bytes);
+            return std::shared_ptr<T>(cache.get(), [cache, name](T*) mutable {
+                MemoryBudget::getBudget()->release(name);
+                cache.reset();
+            });
+        }
+
+        void setVerbose(int verbose) {
+            verbose_ = verbose;
+        }
+
+    private:
+
+        GeneratorCacheRegistry() {
+        }
+
+        /** Weak references to the caches by key. */
+        std::map<std::string, std::weak_ptr<const void>> caches_;
+
+        std::mutex mutex_;
+
+        /** Directory for caches shared between processes (empty if disabled). */
+        std::string sharedMemoryDir_;
+
+        int verbose_{1};
+};
+
+}
+
+#endif
@@ -0,0 +1,225 @@
+/**
+ * @file LHEEventCache.h
+ * @brief Class for caching LHE events in contiguous records
+ */
+
+#ifndef HPSSIM_LHEEVENTCACHE_H_
+#define HPSSIM_LHEEVENTCACHE_H_
+
+#include "SharedCacheFile.h"
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+namespace hpssim {
+
+/**
+ * @struct LHEParticleRecord
+ * @brief Particle record of an LHE event with the same fields as LHEParticle
+ * @note Mothers are referenced by their MOTHUP index in the event instead of by pointer.
+ */
+struct LHEParticleRecord {
+        int idup;
+        int istup;
+        int mothup[2];
+        int icolup[2];
+        double pup[5];
+        double vtimup;
+        double spinup;
+};
+
+/**
+ * @struct LHEEventRecord
+ * @brief Event information record of an LHE event with the range of its particles in the cache
+ */
+struct LHEEventRecord {
+        int nup;
+        int idprup;
+        double xwgtup;
+        double scalup;
+        double aqedup;
+        double aqcdup;
+        uint32_t firstParticle;
+        uint32_t nParticles;
+};
+
+/**
+ * @class LHEEventCache
+ * @brief Arena of LHE events where the particle records of all events are stored contiguously
+ *
+ * @note
+ * The records have no pointers or owned memory, so the whole cache is freed at once
+ * without visiting the individual events or particles.  The records can also be packed into
+ * a SharedCacheFile and used from there by other processes without copying them.
+ */
+class LHEEventCache {
+
+    public:
+
+        /**
+         * Free all events and particles.
+         */
+        void clear() {
+            std::vector<LHEEventRecord>().swap(events_);
+            std::vector<LHEParticleRecord>().swap(particles_);
+            unmap();
+        }
+
+        /**
+         * Reserve space for a number of events, e.g. from the file header.
+         */
+        void reserve(long nEvents) {
+            events_.reserve(nEvents);
+        }
+
+        /**
+         * Start a new event at the end of the cache.
+         */
+        LHEEventRecord& addEvent() {
+            events_.push_back(LHEEventRecord());
+            LHEEventRecord& event = events_.back();
+            event.firstParticle = particles_.size();
+            event.nParticles = 0;
+            return event;
+        }
+
+        /**
+         * Add a particle to the last event.
+         */
+        LHEParticleRecord& addParticle() {
+            particles_.push_back(LHEParticleRecord());
+            events_.back().nParticles++;
+            return particles_.back();
+        }
+
+        /**
+         * Copy an event from another cache to the end of this one.
+         */
+        void addEvent(const LHEEventCache& source, long index) {
+            const LHEEventRecord& sourceEvent = source.getEvent(index);
+            LHEEventRecord& event = addEvent();
+            event.nup = sourceEvent.nup;
+            event.idprup = sourceEvent.idprup;
+            event.xwgtup = sourceEvent.xwgtup;
+            event.scalup = sourceEvent.scalup;
+            event.aqedup = sourceEvent.aqedup;
+            event.aqcdup = sourceEvent.aqcdup;
+            const LHEParticleRecord* particles = source.getParticles(sourceEvent);
+            particles_.insert(particles_.end(), particles, particles + sourceEvent.nParticles);
+            event.nParticles = sourceEvent.nParticles;
+        }
+
+        /**
+         * Remove an event record.  Its particles stay in the arena until it is cleared.
+         */
+        void removeEvent(long index) {
+            if (file_) {
+                // Copy the records out of the shared file so they can be modified.
+                events_.assign(mappedEvents_, mappedEvents_ + nMappedEvents_);
+                particles_.assign(mappedParticles_, mappedParticles_ + nMappedParticles_);
+                unmap();
+            }
+            events_.erase(events_.begin() + index);
+        }
+
+        long size() const {
+            return file_ ? nMappedEvents_ : events_.size();
+        }
+
+        const LHEEventRecord& getEvent(long index) const {
+            return file_ ? mappedEvents_[index] : events_[index];
+        }
+
+        /**
+         * Get the particles of an event, which are contiguous in memory.
+         */
+        const LHEParticleRecord* getParticles(const LHEEventRecord& event) const {
+            return (file_ ? mappedParticles_ : particles_.data()) + event.firstParticle;
+        }
+
+        /**
+         * Get all particles in the cache for modification (not available when mapped from a file).
+         */
+        std::vector<LHEParticleRecord>& getParticles() {
+            return particles_;
+        }
+
+        /**
+         * Get the number of bytes used by the records, not counting a shared file.
+         */
+        size_t getMemoryUsage() const {
+            return events_.capacity() * sizeof(LHEEventRecord) + particles_.capacity() * sizeof(LHEParticleRecord);
+        }
+
+        /**
+         * Pack the records into the data of a shared file.
+         * @param data The data to write or null to only compute the size.
+         * @return The size of the packed data.
+         */
+        size_t pack(char* data) const {
+            uint64_t counts[2] = {events_.size(), particles_.size()};
+            size_t offset = 0;
+            SharedCacheFile::pack(data, offset, counts, 2);
+            SharedCacheFile::pack(data, offset, events_.data(), events_.size());
+            SharedCacheFile::pack(data, offset, particles_.data(), particles_.size());
+            return offset;
+        }
+
+        /**
+         * Use the records packed in a complete shared file instead of the records in this cache.
+         */
+        void map(std::shared_ptr<SharedCacheFile> file) {
+            clear();
+            size_t offset = 0;
+            const uint64_t* counts = SharedCacheFile::map<uint64_t>(file->getData(), offset, 2);
+            nMappedEvents_ = counts[0];
+            nMappedParticles_ = counts[1];
+            mappedEvents_ = SharedCacheFile::map<LHEEventRecord>(file->getData(), offset, nMappedEvents_);
+            mappedParticles_ = SharedCacheFile::map<LHEParticleRecord>(file->getData(), offset, nMappedParticles_);
+            file_ = file;
+        }
+
+        /**
+         * Print a particle record in the same format as LHEParticle.
+         */
+        static void print(const LHEParticleRecord& p, std::ostream& stream) {
+            stream << "LHEParticle { " << "IDUP: " << p.idup << ", ISTUP: " << p.istup << ", MOTHUP[0]: "
+                    << p.mothup[0] << ", MOTHUP[1]: " << p.mothup[1] << ", ICOLUP[0]: " << p.icolup[0]
+                    << ", ICOLUP[1]: " << p.icolup[1] << ", PUP[0]: " << p.pup[0] << ", PUP[1]: " << p.pup[1]
+                    << ", PUP[2]: " << p.pup[2] << ", PUP[3]: " << p.pup[3] << ", PUP[4]: " << p.pup[4]
+                    << ", VTIMUP: " << p.vtimup << ", SPINUP: " << p.spinup << " }" << std::endl;
+        }
+
+    private:
+
+        void unmap() {
+            file_.reset();
+            mappedEvents_ = nullptr;
+            mappedParticles_ = nullptr;
+            nMappedEvents_ = 0;
+            nMappedParticles_ = 0;
+        }
+
+    private:
+
+        /** The event records. */
+        std::vector<LHEEventRecord> events_;
+
+        /** The particle records of all events. */
+        std::vector<LHEParticleRecord> particles_;
+
+        /** The shared file with the records when they are mapped. */
+        std::shared_ptr<SharedCacheFile> file_;
+
+        /** The records in the shared file. */
+        const LHEEventRecord* mappedEvents_{nullptr};
+        const LHEParticleRecord* mappedParticles_{nullptr};
+        long nMappedEvents_{0};
+        size_t nMappedParticles_{0};
+};
+
+}
+
+#endif
@@ -13,11 +13,22 @@
 #include "LHEReader.h"
 #include "PrimaryGenerator.h"
 
+#include <memory>
+
 namespace hpssim {
 
 /**
  * @class LHEPrimaryGenerator
- * @brief Generates a Geant4 event from an LHEEvent
+ * @brief Generates a Geant4 event from LHE event data
+ *
+ * @note
+ * Events are read directly into LHEEventCache records, either one at a time
+ * when reading sequentially or for the whole file in the random access modes.
+ * The cache of a file is shared through the GeneratorCacheRegistry with other
+ * LHE generators that read the same file with the same deterministic transforms,
+ * and with other processes if a shared memory directory is set.
+ * If the cache of a file does not fit in the MemoryBudget, only the positions and
+ * weights of its events are kept and events are parsed again when they are read.
  */
 class LHEPrimaryGenerator: public PrimaryGenerator {
 
@@ -54,8 +65,18 @@ class LHEPrimaryGenerator: public PrimaryGenerator {
 
         void openFile(std::string file);
 
+        void reuseFile();
+
+        long getFileEventCount(std::string file);
+
         void cacheEvents();
 
+        double getEventWeight(long index);
+
+        bool supportsCacheTransform();
+
+        std::string getCacheKey();
+
         void deleteEvent();
 
     private:
@@ -63,16 +84,48 @@ class LHEPrimaryGenerator: public PrimaryGenerator {
         // Setup event sampling if using cross section.
         void setupEventSampling();
 
+        // Index the events of the file instead of caching them.
+        void indexEvents(const LHEEventCache& cache, std::vector<std::streampos>& offsets);
+
+        // Map the origin with the deterministic transforms to get the position of the vertices.
+        void updateVertexPosition();
+
+        // Apply the deterministic transforms to the momenta of the particles.
+        static void transformMomenta(std::vector<LHEParticleRecord>& particles, const FusedVertexTransform& transform);
+
+        std::string getIndexName();
+
     private:
 
         /** The LHE reader with the event data. */
         LHEReader* reader_;
 
-        /** The current LHE event. */
-        LHEEvent* lheEvent_;
+        /** Holds the current event when reading sequentially. */
+        LHEEventCache eventBuffer_;
+
+        /** Cache of LHE events when running in random mode, which may be shared with other generators. */
+        std::shared_ptr<const LHEEventCache> events_;
+
+        /** Private copy of the cache when events have been removed from it. */
+        std::shared_ptr<LHEEventCache> ownEvents_;
+
+        /** The cache with the current event, or null if there is no current event. */
+        const LHEEventCache* currentCache_{nullptr};
+
+        /** Index of the current event in its cache. */
+        long currentIndex_{0};
+
+        /** Positions of the events in the file when they are indexed instead of cached. */
+        std::vector<std::streampos> eventOffsets_;
+
+        /** Weights of the indexed events. */
+        std::vector<double> eventWeights_;
+
+        /** Primaries created for the particles of the current event by their index. */
+        std::vector<G4PrimaryParticle*> primaries_;
 
-        /** Queue of LHE events when running in random mode. */
-        std::vector<LHEEvent*> events_;
+        /** Vertex position of cached events with the transforms applied. */
+        G4ThreeVector vertexPosition_;
 };
 
 }
@@ -8,6 +8,7 @@
 #define HPSSIM_LHEREADER_H_
 
 #include "LHEEvent.h"
+#include "LHEEventCache.h"
 
 #include <fstream>
 
@@ -38,6 +39,22 @@ class LHEReader {
          */
         LHEEvent* readNextEvent();
 
+        /**
+         * Read the next event directly into the records of an event cache.
+         * @return False if there are no more events.
+         */
+        bool readNextEvent(LHEEventCache& cache);
+
+        /**
+         * Get the current position in the file, e.g. to index events.
+         */
+        std::streampos tell();
+
+        /**
+         * Go to a position in the file, e.g. to read an indexed event.
+         */
+        void seek(std::streampos pos);
+
         /**
          * Get the cross section for the file, read from header data.
          */
@@ -10,33 +10,58 @@
 
 #include "G4SystemOfUnits.hh"
 
-#include <map>
+#include <algorithm>
+#include <bitset>
+#include <utility>
+#include <vector>
 
 namespace hpssim {
 
+/**
+ * @class MCParticleBuilder
+ * @brief Builds the MCParticle collection of an event from its saved trajectories
+ *
+ * @note
+ * The particles are built in a single pass over the trajectories and kept in an array
+ * indexed by track ID.  Parents which are built after their daughters are linked at
+ * the end of the pass.
+ */
 class MCParticleBuilder {
 
     public:
 
-        typedef std::map<G4int, IMPL::MCParticleImpl*> MCParticleMap;
-
         MCParticleBuilder(TrackMap* trackMap);
 
         virtual ~MCParticleBuilder();
 
-        void buildParticleMap(G4TrajectoryContainer* trajectories, IMPL::LCCollectionVec* collVec);
-
+        /**
+         * Find the MCParticle of a track, or of its nearest ancestor with a saved trajectory.
+         * @return The MCParticle or null if there is none.
+         */
         IMPL::MCParticleImpl* findMCParticle(G4int trackID);
 
-        void buildMCParticle(Trajectory* traj);
-
         IMPL::LCCollectionVec* buildMCParticleColl(const G4Event* anEvent);
 
         TrackMap& getTrackMap();
 
     private:
 
-        MCParticleMap particleMap_;
+        IMPL::MCParticleImpl* buildMCParticle(Trajectory* traj);
+
+        /**
+         * Get the MCParticle built for a trajectory by its track ID.
+         */
+        IMPL::MCParticleImpl* getMCParticle(G4int trackID) {
+            return (size_t) trackID < particles_.size() ? particles_[trackID] : nullptr;
+        }
+
+    private:
+
+        /** MCParticles of the current event by track ID. */
+        std::vector<IMPL::MCParticleImpl*> particles_;
+
+        /** Particles with a parent that was not built yet and the track ID of that parent. */
+        std::vector<std::pair<IMPL::MCParticleImpl*, G4int>> unlinked_;
 
         TrackMap* trackMap_;
 };
@@ -0,0 +1,143 @@
+/**
+ * @file MemoryBudget.h
+ * @brief Class for tracking the memory used by large data caches against a limit
+ */
+
+#ifndef HPSSIM_MEMORYBUDGET_H_
+#define HPSSIM_MEMORYBUDGET_H_
+
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace hpssim {
+
+/**
+ * @class MemoryBudget
+ * @brief Tracks the bytes used by each event cache, the event arena, etc. against a global limit
+ *
+ * @note
+ * The budget does not allocate or free anything itself.  Users report their usage under a unique
+ * name, and check with fits() whether they may grow, so they can degrade gracefully
+ * (e.g. use a more compact cache or stream their data) instead of exceeding the limit.
+ * A limit of zero means there is no limit.
+ */
+class MemoryBudget {
+
+    public:
+
+        static MemoryBudget* getBudget() {
+            static MemoryBudget theInstance;
+            return &theInstance;
+        }
+
+        /**
+         * Set the limit in bytes (zero for no limit).
+         */
+        void setLimit(size_t limit) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            limit_ = limit;
+        }
+
+        size_t getLimit() {
+            return limit_;
+        }
+
+        /**
+         * Set the number of bytes used by a named user.
+         */
+        void setUsage(const std::string& name, size_t bytes) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            total_ -= usage_[name];
+            usage_[name] = bytes;
+            total_ += bytes;
+            if (total_ > peak_) {
+                peak_ = total_;
+            }
+        }
+
+        /**
+         * Remove a named user from the budget.
+         */
+        void release(const std::string& name) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = usage_.find(name);
+            if (it != usage_.end()) {
+                total_ -= it->second;
+                usage_.erase(it);
+            }
+        }
+
+        size_t getUsage(const std::string& name) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = usage_.find(name);
+            return it != usage_.end() ? it->second : 0;
+        }
+
+        size_t getTotal() {
+            return total_;
+        }
+
+        /**
+         * Return true if a named user may use this many bytes in total without exceeding the limit.
+         */
+        bool fits(const std::string& name, size_t bytes) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!limit_) {
+                return true;
+            }
+            auto it = usage_.find(name);
+            size_t others = total_ - (it != usage_.end() ? it->second : 0);
+            return others + bytes <= limit_;
+        }
+
+        /**
+         * Print the usage of every user and the total.
+         */
+        void print(std::ostream& os) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            os << "MemoryBudget: Usage by cache in MB" << std::endl;
+            for (auto& entry : usage_) {
+                os << "  " << std::setw(10) << std::fixed << std::setprecision(2) << toMB(entry.second) << "  "
+                        << entry.first << std::endl;
+            }
+            os << "  " << std::setw(10) << toMB(total_) << "  total (peak " << toMB(peak_) << ", limit ";
+            if (limit_) {
+                os << toMB(limit_) << ")" << std::endl;
+            } else {
+                os << "none)" << std::endl;
+            }
+            os.unsetf(std::ios_base::floatfield);
+        }
+
+    private:
+
+        MemoryBudget() {
+        }
+
+        static double toMB(size_t bytes) {
+            return bytes / (1024. * 1024.);
+        }
+
+    private:
+
+        /** Bytes used by each user. */
+        std::map<std::string, size_t> usage_;
+
+        /** Total bytes used. */
+        size_t total_{0};
+
+        /** Highest total. */
+        size_t peak_{0};
+
+        /** Limit in bytes (zero for no limit). */
+        size_t limit_{0};
+
+        std::mutex mutex_;
+};
+
+}
+
+#endif
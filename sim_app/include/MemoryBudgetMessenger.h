@@ -0,0 +1,48 @@
+#ifndef HPSSIM_MEMORYBUDGETMESSENGER_H_
+#define HPSSIM_MEMORYBUDGETMESSENGER_H_
+
+/*
+ * Geant4
+ */
+#include "G4UImessenger.hh"
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithoutParameter.hh"
+
+namespace hpssim {
+
+/**
+ * @class MemoryBudgetMessenger
+ * @brief Messenger for setting the memory limit of the caches and printing their usage
+ */
+class MemoryBudgetMessenger : public G4UImessenger {
+
+    public:
+
+        MemoryBudgetMessenger();
+
+        virtual ~MemoryBudgetMessenger();
+
+        void SetNewValue(G4UIcommand* command, G4String newValues);
+
+    private:
+
+        /**
+         * UI dir for memory commands.
+         */
+        G4UIdirectory* memoryDir_;
+
+        /**
+         * UI command to set the memory limit in MB.
+         */
+        G4UIcmdWithADouble* limitCmd_;
+
+        /**
+         * UI command to print the memory usage.
+         */
+        G4UIcmdWithoutParameter* printCmd_;
+};
+
+} // namespace hpssim
+
+#endif
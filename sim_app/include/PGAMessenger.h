@@ -4,6 +4,8 @@
 #include "G4UImessenger.hh"
 #include "G4UIdirectory.hh"
 #include "G4UIcommand.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithAString.hh"
 
 #include "PrimaryGenerator.h"
 
@@ -42,6 +44,10 @@ class PGAMessenger : public G4UImessenger {
 
         G4UIcmdWithAnInteger* verboseCmd_;
 
+        G4UIcmdWithABool* planCmd_;
+
+        G4UIcmdWithAString* sharedCacheDirCmd_;
+
         std::map<std::string, SourceType> sourceType_;
 };
 
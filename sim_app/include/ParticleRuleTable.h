@@ -0,0 +1,134 @@
+/**
+ * @file ParticleRuleTable.h
+ * @brief Classes for resolving particles from macro commands and indexing rules by particle species
+ */
+
+#ifndef HPSSIM_PARTICLERULETABLE_H_
+#define HPSSIM_PARTICLERULETABLE_H_
+
+/*
+ * Geant4
+ */
+#include "G4ParticleDefinition.hh"
+#include "G4ParticleTable.hh"
+
+/*
+ * C++
+ */
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace hpssim {
+
+/**
+ * @class ParticleNames
+ * @brief Resolves particles given by name or PDG code in macro commands
+ */
+class ParticleNames {
+
+    public:
+
+        /**
+         * Find a particle by its name or PDG code.
+         * @param particle The name or PDG code of the particle.
+         * @return The particle or null if it does not exist.
+         */
+        static G4ParticleDefinition* find(const std::string& particle) {
+            char* end;
+            long pdg = std::strtol(particle.c_str(), &end, 10);
+            if (particle.size() && !*end) {
+                return G4ParticleTable::GetParticleTable()->FindParticle((int) pdg);
+            }
+            return G4ParticleTable::GetParticleTable()->FindParticle(particle);
+        }
+
+        /**
+         * Get the PDG codes of a list of particles, which must all exist.
+         * @param particles The names or PDG codes of the particles.
+         * @param origin The method which resolves the particles, for the error message.
+         * @return The PDG codes in the same order.
+         */
+        static std::vector<int> getPDGCodes(const std::vector<std::string>& particles, const std::string& origin) {
+            std::vector<int> pdgCodes;
+            for (auto& particle : particles) {
+                G4ParticleDefinition* def = find(particle);
+                if (!def) {
+                    G4Exception(origin.c_str(), "", FatalException,
+                            G4String("The particle '" + particle + "' does not exist."));
+                }
+                pdgCodes.push_back(def->GetPDGEncoding());
+            }
+            return pdgCodes;
+        }
+};
+
+/**
+ * @class ParticleRuleTable
+ * @brief Lists of the candidate rules for each particle species, in the order the rules were added
+ *
+ * @note
+ * Rules which are checked in order until one matches a track are added here with the PDG
+ * codes of their particles, or none for rules which apply to any particle.  Looking up the
+ * candidates of a species then only gives the rules which can apply to it, so the rules for
+ * other species are not checked for every track.
+ */
+template<class RuleType>
+class ParticleRuleTable {
+
+    public:
+
+        /**
+         * Add a rule after the existing ones.
+         * @param rule The rule.
+         * @param pdgCodes The PDG codes of the particles of the rule (empty for any).
+         */
+        void add(RuleType* rule, const std::vector<int>& pdgCodes) {
+            if (pdgCodes.empty()) {
+                anyParticleRules_.push_back(rule);
+                for (auto& entry : tables_) {
+                    entry.second.push_back(rule);
+                }
+                return;
+            }
+            for (auto pdg : pdgCodes) {
+                auto it = tables_.find(pdg);
+                if (it == tables_.end()) {
+                    // The rules for any particle which were added before apply to the new species.
+                    it = tables_.insert(std::make_pair(pdg, anyParticleRules_)).first;
+                }
+                auto& table = it->second;
+                if (table.empty() || table.back() != rule) {
+                    table.push_back(rule);
+                }
+            }
+        }
+
+        /**
+         * Get the candidate rules for a particle species.
+         * @param pdg The PDG code of the particle.
+         * @return The rules in their original order.
+         */
+        const std::vector<RuleType*>& getCandidates(int pdg) const {
+            auto it = tables_.find(pdg);
+            return it != tables_.end() ? it->second : anyParticleRules_;
+        }
+
+        void clear() {
+            tables_.clear();
+            anyParticleRules_.clear();
+        }
+
+    private:
+
+        /** Candidate rules by PDG code for the particles named in any rule. */
+        std::unordered_map<int, std::vector<RuleType*>> tables_;
+
+        /** Candidate rules for other particles. */
+        std::vector<RuleType*> anyParticleRules_;
+};
+
+}
+
+#endif
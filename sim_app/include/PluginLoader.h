@@ -8,6 +8,7 @@
 #define HPSSIM_PLUGINLOADER_H_
 
 // LDMX
+#include "PluginRegistry.h"
 #include "SimPlugin.h"
 
 namespace hpssim {
@@ -15,6 +16,10 @@ namespace hpssim {
 /**
  * @class PluginLoader
  * @brief Loads user sim plugin classes from external shared libraries
+ *
+ * @note
+ * Plugins which are linked into the application and registered in the PluginRegistry
+ * are created directly, without opening the library.
  */
 class PluginLoader {
 
@@ -48,6 +53,11 @@ class PluginLoader {
          * Map of plugins to their handles.
          */
         std::map<SimPlugin*, void*> pluginHandles_;
+
+        /**
+         * Map of plugins from the registry to their destroy functions.
+         */
+        std::map<SimPlugin*, PluginRegistry::DestroyFunction> registeredPlugins_;
 };
 
 }
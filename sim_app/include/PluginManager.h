@@ -13,10 +13,15 @@
 
 // STL
 #include <algorithm>
+#include <array>
+#include <chrono>
+#include <map>
 #include <ostream>
 
 // Geant4
 #include "G4ClassificationOfNewTrack.hh"
+#include "G4UserStackingAction.hh"
+#include "G4UserSteppingAction.hh"
 
 namespace hpssim {
 
@@ -31,6 +36,19 @@ class PluginMessenger;
  * It is also responsible for activating the user action hooks for all registered plugins.
  * Only one instance of a given plugin can be loaded at a time.
  *
+ * @par
+ * The plugins of each action are kept in a fixed array of lists indexed by the action,
+ * so dispatching a hook is only a loop over pointers.  The stepping and stacking user
+ * actions are only installed in the run manager while some plugin subscribes to them
+ * (the stacking action also for staging plugins), so Geant4 does not call into the
+ * manager for every step when no plugin needs it.
+ * The stepping filters of the plugins are checked before calling them, sharing the
+ * lookup of the volume tags between plugins.
+ *
+ * @par
+ * Optionally, the calls of each plugin and action are counted and one in every few calls
+ * is timed, so the time spent in each plugin can be estimated with little overhead.
+ *
  * @see SimPlugin
  * @see PluginLoader
  */
@@ -43,7 +61,30 @@ class PluginManager {
          */
         typedef std::vector<SimPlugin*> PluginVec;
 
-        typedef std::map<SimPlugin::PluginAction, PluginVec> PluginActionMap;
+        /**
+         * Lists of plugins indexed by action.
+         */
+        typedef std::array<PluginVec, SimPlugin::STAGING + 1> PluginActionTable;
+
+        /**
+         * Call count and sampled time of the hooks of a plugin for one action.
+         */
+        struct HookStats {
+
+                /** Number of calls. */
+                unsigned long calls{0};
+
+                /** Number of timed calls. */
+                unsigned long sampledCalls{0};
+
+                /** Total time of the timed calls [s]. */
+                double sampledTime{0.};
+        };
+
+        /**
+         * Hook statistics of a plugin indexed by action.
+         */
+        typedef std::array<HookStats, SimPlugin::STAGING + 1> PluginStats;
 
         static PluginManager* getPluginManager() {
             static PluginManager theInstance;
@@ -132,6 +173,18 @@ class PluginManager {
          */
         void stackingPrepareNewEvent();
 
+        /**
+         * Return true if any staging plugin puts a new track in the first stage.
+         * @param aTrack The Geant4 track.
+         */
+        bool stagingIsFirstStage(const G4Track* aTrack);
+
+        /**
+         * Return true if all staging plugins accept the event after a stage.
+         * @param stage The stage which is finished.
+         */
+        bool stagingAcceptEvent(int stage);
+
         /**
          * Find a plugin by name.
          * @param pluginName The name of the plugin.
@@ -161,8 +214,113 @@ class PluginManager {
 
         void initializePlugins();
 
+        /**
+         * Return true if any plugin is registered for an action.
+         * @param action The plugin action.
+         */
+        bool hasPlugins(SimPlugin::PluginAction action) const {
+            return !actions_[action].empty();
+        }
+
+        /**
+         * Set the user actions which are only installed while plugins subscribe to them.
+         * The actions are owned by the run manager once they are installed.
+         * @param steppingAction The stepping action.
+         * @param stackingAction The stacking action.
+         */
+        void setUserActions(G4UserSteppingAction* steppingAction, G4UserStackingAction* stackingAction);
+
+        /**
+         * Enable or disable the hook statistics.
+         * @param enabled True to count and time the plugin hooks.
+         */
+        void setStatsEnabled(bool enabled) {
+            statsEnabled_ = enabled;
+        }
+
+        /**
+         * Set the interval of the timed calls of each hook.
+         * @param interval Time one in every this many calls.
+         */
+        void setStatsInterval(unsigned interval) {
+            statsInterval_ = std::max(interval, 1u);
+        }
+
+        /**
+         * Reset the hook statistics.
+         */
+        void resetStats();
+
+        /**
+         * Print the hook statistics of the registered plugins.
+         * @param os The output stream.
+         */
+        void printStats(std::ostream& os);
+
     private:
 
+        /**
+         * A stepping plugin with its filter.
+         */
+        struct SteppingEntry {
+                SimPlugin* plugin;
+                SimPlugin::SteppingFilter filter;
+                HookStats* stats;
+        };
+
+        /**
+         * Call a hook of the plugins of an action, counting and timing the calls if enabled.
+         * @param action The plugin action.
+         * @param hook Function which calls the hook of a plugin.
+         */
+        template<class Hook>
+        void dispatch(SimPlugin::PluginAction action, Hook hook) {
+            const PluginVec& plugins = actions_[action];
+            if (!statsEnabled_) {
+                for (auto plugin : plugins) {
+                    hook(plugin);
+                }
+                return;
+            }
+            const std::vector<HookStats*>& stats = actionStats_[action];
+            for (size_t i = 0; i < plugins.size(); i++) {
+                SimPlugin* plugin = plugins[i];
+                call(*stats[i], [&]() {
+                    hook(plugin);
+                });
+            }
+        }
+
+        /**
+         * Call a hook, timing one in every statsInterval_ calls.
+         */
+        template<class Call>
+        void call(HookStats& stats, Call hook) {
+            if (++stats.calls % statsInterval_) {
+                hook();
+                return;
+            }
+            auto start = std::chrono::steady_clock::now();
+            hook();
+            stats.sampledTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            ++stats.sampledCalls;
+        }
+
+        /**
+         * Point the statistics of each action list to the statistics of its plugins.
+         */
+        void updateActionStats();
+
+        /**
+         * Read the stepping filters of the stepping plugins.
+         */
+        void updateSteppingFilters();
+
+        /**
+         * Install or remove the optional user actions depending on their subscribers.
+         */
+        void updateUserActions();
+
         /**
          * Destroy a plugin.
          * @param plugin Pointer to plugin that should be destroyed.
@@ -200,7 +358,41 @@ class PluginManager {
          */
         PluginVec plugins_;
 
-        PluginActionMap actions_;
+        /**
+         * The registered plugins of each action.
+         */
+        PluginActionTable actions_;
+
+        /**
+         * The stepping plugins with their filters.
+         */
+        std::vector<SteppingEntry> steppingPlugins_;
+
+        /**
+         * The hook statistics of the registered plugins.
+         */
+        std::map<SimPlugin*, PluginStats> stats_;
+
+        /**
+         * The hook statistics of the plugins of each action, in the same order as actions_.
+         */
+        std::array<std::vector<HookStats*>, SimPlugin::STAGING + 1> actionStats_;
+
+        /**
+         * True if the hook statistics are enabled.
+         */
+        bool statsEnabled_{false};
+
+        /**
+         * Interval of the timed calls of each hook.
+         */
+        unsigned statsInterval_{10};
+
+        /**
+         * The optional user actions.
+         */
+        G4UserSteppingAction* steppingAction_{nullptr};
+        G4UserStackingAction* stackingAction_{nullptr};
 };
 
 }
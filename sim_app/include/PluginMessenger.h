@@ -66,6 +66,16 @@ class PluginMessenger : public G4UImessenger {
          * Command for listing currently registered plugins.
          */
         G4UIcommand* listCmd_;
+
+        /**
+         * Command for enabling, printing and resetting the plugin hook statistics.
+         */
+        G4UIcommand* statsCmd_;
+
+        /**
+         * Command for setting the interval of the timed hook calls.
+         */
+        G4UIcommand* statsIntervalCmd_;
 };
 
 }
@@ -0,0 +1,101 @@
+/**
+ * @file PluginRegistry.h
+ * @brief Class providing a registry of plugins which are linked into the application
+ */
+
+#ifndef HPSSIM_PLUGINREGISTRY_H_
+#define HPSSIM_PLUGINREGISTRY_H_
+
+#include "SimPlugin.h"
+
+#include <iostream>
+#include <map>
+#include <string>
+
+namespace hpssim {
+
+/**
+ * @class PluginRegistry
+ * @brief Registry of the create and destroy functions of plugins by name
+ *
+ * @note
+ * When the application is built with HPSSIM_STATIC_PLUGINS, the plugins and filters are
+ * linked into it and the SIM_PLUGIN macro registers each plugin here during static
+ * initialization.  The PluginLoader looks up plugins in this registry before it tries to
+ * load them from a shared library, so the same macro commands work in both builds.
+ */
+class PluginRegistry {
+
+    public:
+
+        typedef SimPlugin* (*CreateFunction)();
+        typedef void (*DestroyFunction)(SimPlugin*);
+
+        /**
+         * The functions for creating and destroying a plugin.
+         */
+        struct Entry {
+                CreateFunction create;
+                DestroyFunction destroy;
+        };
+
+        static PluginRegistry* getRegistry() {
+            static PluginRegistry theInstance;
+            return &theInstance;
+        }
+
+        /**
+         * Register a plugin.
+         * @param name The name of the plugin.
+         * @param create The function for creating the plugin.
+         * @param destroy The function for destroying the plugin.
+         */
+        void add(const std::string& name, CreateFunction create, DestroyFunction destroy) {
+            if (entries_.count(name)) {
+                std::cerr << "PluginRegistry: Ignoring duplicate plugin '" << name << "'" << std::endl;
+                return;
+            }
+            entries_[name] = Entry{create, destroy};
+        }
+
+        /**
+         * Find a plugin by name.
+         * @return The entry of the plugin or null if it is not registered.
+         */
+        const Entry* find(const std::string& name) const {
+            auto it = entries_.find(name);
+            return it != entries_.end() ? &it->second : nullptr;
+        }
+
+        void print(std::ostream& os) const {
+            for (auto& entry : entries_) {
+                os << entry.first << std::endl;
+            }
+        }
+
+    private:
+
+        PluginRegistry() {
+        }
+
+        /** The registered plugins by name. */
+        std::map<std::string, Entry> entries_;
+};
+
+/**
+ * @class PluginRegistration
+ * @brief Registers a plugin when it is constructed, for static instances in the plugin sources
+ */
+class PluginRegistration {
+
+    public:
+
+        PluginRegistration(const std::string& name, PluginRegistry::CreateFunction create,
+                PluginRegistry::DestroyFunction destroy) {
+            PluginRegistry::getRegistry()->add(name, create, destroy);
+        }
+};
+
+}
+
+#endif
@@ -3,6 +3,9 @@
 
 #include "G4VPrimaryGenerator.hh"
 
+#include "CLHEP/Random/RandFlat.h"
+
+#include "AliasTable.h"
 #include "EventSampling.h"
 #include "VertexTransform.h"
 #include "Parameters.h"
@@ -104,7 +107,8 @@ class PrimaryGenerator : public G4VPrimaryGenerator {
             Linear,      // Cache the file, then read content in order.
             Random,      // Cache the file, then read the events randomly, making sure there are no duplicates.
             PureRandom,  // Cache the file, then reads the events randomly, with possible duplicates.
-            SemiRandom   // Cache the file, then read the events randomly among 1k blocks.
+            SemiRandom,  // Cache the file, then read the events randomly among 1k blocks.
+            Weighted     // Cache the file, then reads the events randomly in proportion to their weights, with possible duplicates.
         };
 
         /**
@@ -192,11 +196,68 @@ class PrimaryGenerator : public G4VPrimaryGenerator {
             return sampling_;
         }
 
+        /**
+         * Get the number of events to sample for a Geant4 event, which comes from
+         * the sampling plan if one was made for this run.
+         */
+        int getNumberOfSamples(G4Event* anEvent) {
+            int eventID = anEvent->GetEventID();
+            if (eventID >= 0 && eventID < (int) samplingPlan_.size()) {
+                return samplingPlan_[eventID];
+            }
+            return sampling_->getNumberOfEvents(anEvent);
+        }
+
+        /**
+         * Pre-draw the number of events to sample for every event in the run.
+         */
+        void planSampling(int nEvents, std::mt19937& engine) {
+            samplingPlan_.resize(nEvents);
+            plannedDemand_ = 0;
+            for (int eventID = 0; eventID < nEvents; eventID++) {
+                samplingPlan_[eventID] = sampling_->getNumberOfEvents(eventID, engine);
+                plannedDemand_ += samplingPlan_[eventID];
+            }
+        }
+
+        /**
+         * Clear the sampling plan so the number of events is sampled when each event is generated.
+         */
+        void clearSamplingPlan() {
+            samplingPlan_.clear();
+            plannedDemand_ = -1;
+        }
+
+        /**
+         * Get the total number of events the sampling plan will read from this generator
+         * in the run, or -1 if there is no plan.
+         */
+        long getPlannedDemand() {
+            return plannedDemand_;
+        }
+
+        /**
+         * Count the events in all of the generator's input files from their header data.
+         * @return The number of events or -1 if it is not known for some file.
+         */
+        long countAvailableEvents() {
+            long total = 0;
+            for (auto file : files_) {
+                long count = getFileEventCount(file);
+                if (count < 0) {
+                    return -1;
+                }
+                total += count;
+            }
+            return total;
+        }
+
         /**
          * Add a transform to be applied to this generator's events.
          */
         void addTransform(VertexTransform* transform) {
             transforms_.push_back(transform);
+            fusedTransform_.clear();
         }
 
         /**
@@ -210,8 +271,34 @@ class PrimaryGenerator : public G4VPrimaryGenerator {
          * Apply transforms to a generated event.
          */
         void applyTransforms(G4Event* anEvent) {
-            for (auto transform : transforms_) {
-                transform->transform(anEvent);
+            if (!fusedTransform_.isCompiled()) {
+                compileTransforms();
+            }
+            if (cacheTransformed_) {
+                fusedTransform_.transformRandom(anEvent);
+            } else {
+                fusedTransform_.transform(anEvent);
+            }
+        }
+
+        /**
+         * Return true if the deterministic part of the transforms was applied
+         * to the cached events of the current file.
+         */
+        bool isCacheTransformed() {
+            return cacheTransformed_;
+        }
+
+        /**
+         * Compile the list of transforms into a single fused transform
+         * which is applied in one pass over the event.
+         */
+        void compileTransforms() {
+            fusedTransform_.compile(transforms_);
+            if (verbose_ > 1 && transforms_.size()) {
+                std::cout << "PrimaryGenerator: Compiled " << transforms_.size() << " transforms for '"
+                        << name_ << "'" << std::endl;
+                fusedTransform_.print(std::cout);
             }
         }
 
@@ -232,18 +319,60 @@ class PrimaryGenerator : public G4VPrimaryGenerator {
          */
         virtual void readNextFile() throw(EndOfDataException) {
             if (fileQueue_.size()) {
-                std::string nextFile = popFile();
-                openFile(nextFile);
+                currentFile_ = popFile();
+                openFile(currentFile_);
+                cacheTransformed_ = false;
+                cacheKey_.clear();
                 if (getReadMode() != PrimaryGenerator::Sequential) {
                     current_event_ = 0;         // We must reset the current event for the file.
+                    cacheTransformed_ = getCacheTransform() != nullptr;
+                    cacheOverBudget_ = false;
                     cacheEvents();
+                    if (getReadMode() == PrimaryGenerator::Sequential || cacheOverBudget_) {
+                        // The cache did not fit in the memory budget.
+                        return;
+                    }
+                    cacheKey_ = getCacheKey();
+                    if (verbose_ > 1 && cacheTransformed_) {
+                        std::cout << "PrimaryGenerator: Applied deterministic transforms to event cache of '"
+                                << name_ << "'" << std::endl;
+                    }
                     createEventList();
+                    createAliasTable();
                 }
             } else {
                 throw EndOfDataException();
             }
         }
 
+        /*
+         * Restart reading the files at the beginning of a run.  If the current file is
+         * the first one in the list and its cache would be built the same way again,
+         * the cache is kept and only the event list and cursor are reset.  The read mode
+         * is restored in case the previous run fell back to reading the files sequentially.
+         */
+        void rewindFiles() throw(EndOfDataException) {
+            readMode_ = userReadMode_;
+            queueFiles();
+            if (!cacheKey_.empty() && getReadMode() != PrimaryGenerator::Sequential && fileQueue_.size()
+                    && fileQueue_.front() == currentFile_ && getCacheKey() == cacheKey_) {
+                popFile();
+                cacheTransformed_ = getCacheTransform() != nullptr;
+                reuseFile();
+                current_event_ = 0;
+                createEventList();
+                if (getReadMode() == PrimaryGenerator::Weighted && !aliasTable_.size()) {
+                    createAliasTable();
+                }
+                if (verbose_ > 1) {
+                    std::cout << "PrimaryGenerator: Reusing event cache of '" << currentFile_ << "' for '"
+                            << name_ << "'" << std::endl;
+                }
+            } else {
+                readNextFile();
+            }
+        }
+
         /*
          * Generate the table to read out the cached events in a particular order.
          * This can be "linear" i.e. 0...N, or "random" where 0..N is randomized, or
@@ -259,6 +388,7 @@ class PrimaryGenerator : public G4VPrimaryGenerator {
             if (getReadMode() == PrimaryGenerator::Random || getReadMode() == PrimaryGenerator::Linear || getReadMode() == PrimaryGenerator::SemiRandom){
                 int n_evt =getNumEvents();
                 if(verbose_ > 3) std::cout << "Number events in file = " << n_evt << std::endl;
+                event_list_.clear();
                 for(int i=0;i<n_evt;++i) event_list_.push_back(i); // Make the linear list of events.
                 if(verbose_ > 3) std::cout << "Number events in cache = " << event_list_.size() << std::endl;
                 if (getReadMode() == PrimaryGenerator::Random ){
@@ -279,13 +409,55 @@ class PrimaryGenerator : public G4VPrimaryGenerator {
                 }
             }
         }
+        /*
+         * Build the alias table over the weights of the cached events for the weighted read mode.
+         */
+        void createAliasTable() {
+            aliasTable_.clear();
+            if (getReadMode() != PrimaryGenerator::Weighted) {
+                return;
+            }
+            int nEvents = getNumEvents();
+            std::vector<double> weights(nEvents);
+            for (int i = 0; i < nEvents; i++) {
+                weights[i] = getEventWeight(i);
+            }
+            if (!aliasTable_.build(weights)) {
+                G4Exception("PrimaryGenerator::createAliasTable", "", FatalException,
+                        G4String("The cached events of '" + name_ + "' have no non-zero weights."));
+            }
+            if (verbose_ > 1) {
+                std::cout << "PrimaryGenerator: Built alias table for " << nEvents << " events of '" << name_
+                        << "' with mean weight " << aliasTable_.getMeanWeight() << std::endl;
+            }
+        }
+
         /**
-         * Set the generator read mode, either Random or Sequential, PureRandon, Linear, SemiRandom.
+         * Sample the index of a cached event in proportion to its weight.
+         */
+        long sampleWeightedEvent() {
+            return aliasTable_.sample(CLHEP::RandFlat::shoot());
+        }
+
+        /**
+         * Set the vertex weights of an event sampled in weighted mode to the mean absolute weight
+         * of the cache, keeping the sign of the original weight, so the sampled events are unweighted.
+         */
+        void unweightEvent(G4Event* anEvent) {
+            double meanWeight = aliasTable_.getMeanWeight();
+            for (auto vertex = anEvent->GetPrimaryVertex(); vertex; vertex = vertex->GetNext()) {
+                vertex->SetWeight(vertex->GetWeight() < 0. ? -meanWeight : meanWeight);
+            }
+        }
+
+        /**
+         * Set the generator read mode, either Random or Sequential, PureRandon, Linear, SemiRandom, Weighted.
          * The validity of the read mode for a particular generator
          * is checked from the PrimaryGeneratorMessenger before this is set.
          */
         void setReadMode(ReadMode readMode) {
             readMode_ = readMode;
+            userReadMode_ = readMode;
         }
 
         /**
@@ -345,12 +517,85 @@ class PrimaryGenerator : public G4VPrimaryGenerator {
         virtual void readNextEvent() throw(EndOfFileException) {
         }
 
+        /**
+         * File-based generators can override this to return the weight of a cached event
+         * by its index, which is used for sampling events in the weighted read mode.
+         */
+        virtual double getEventWeight(long) {
+            return 1.;
+        }
+
+        /**
+         * File-based generators can override this to return true if they apply the
+         * transform from getCacheTransform() to the events in cacheEvents(), so that
+         * only the random shifts are applied when events are sampled from the cache.
+         */
+        virtual bool supportsCacheTransform() {
+            return false;
+        }
+
+        /**
+         * File-based generators can override this to return a key which identifies the
+         * contents of the event cache of the current file, e.g. from GeneratorCacheRegistry::makeKey.
+         * The cache is reused in the next run if the key is not empty and has not changed.
+         */
+        virtual std::string getCacheKey() {
+            return "";
+        }
+
+        /**
+         * Read the files sequentially instead of caching them, e.g. when a cache does not
+         * fit in the MemoryBudget, and reopen the current file from the start.
+         *
+         * @note
+         * Only the Linear mode reads the same events in the same order from the files.  The
+         * other modes would sample different events, so the run is aborted instead.  The read
+         * mode which was set is restored at the next run.
+         */
+        void fallBackToSequential() {
+            if (readMode_ != PrimaryGenerator::Linear) {
+                G4Exception("PrimaryGenerator::fallBackToSequential", "", RunMustBeAborted,
+                        G4String("The event cache of '" + name_ + "' exceeds the memory budget and its read mode cannot fall back to reading the files sequentially."));
+                cacheOverBudget_ = true;
+                return;
+            }
+            G4Exception("PrimaryGenerator::fallBackToSequential", "", JustWarning,
+                    G4String("The event cache of '" + name_ + "' exceeds the memory budget so its files will be read sequentially."));
+            readMode_ = PrimaryGenerator::Sequential;
+            cacheTransformed_ = false;
+            openFile(currentFile_);
+        }
+
+        /**
+         * Get the file that is currently open.
+         */
+        const std::string& getCurrentFile() {
+            return currentFile_;
+        }
+
+        /**
+         * File-based generators can override this to return the number of events
+         * in a file, preferably from header data so the file is not read in full.
+         * @return The number of events or -1 if not known.
+         */
+        virtual long getFileEventCount(std::string) {
+            return -1;
+        }
+
         /**
          * File-based generators should use this hook to open the specified file.
          */
         virtual void openFile(std::string) {
         }
 
+        /**
+         * File-based generators can override this to redo the setup from openFile() which
+         * depends on settings that may have changed, when the current file and its cache
+         * are reused at the start of a new run instead of opening the file again.
+         */
+        virtual void reuseFile() {
+        }
+
         /**
          * Generators should use this hook to cleanup event data that needs to be deleted.
          */  
@@ -391,6 +636,23 @@ class PrimaryGenerator : public G4VPrimaryGenerator {
     
     protected:
 
+        /**
+         * Get the deterministic transform that should be applied to the event cache.
+         * @return The fused transform or null if the cache should not be transformed.
+         */
+        const FusedVertexTransform* getCacheTransform() {
+            if (!supportsCacheTransform()) {
+                return nullptr;
+            }
+            if (!fusedTransform_.isCompiled()) {
+                compileTransforms();
+            }
+            if (fusedTransform_.isFused() && fusedTransform_.isDeterministic()) {
+                return &fusedTransform_;
+            }
+            return nullptr;
+        }
+
         /** Verbose level for print output (1-4). */
         int verbose_{1};
 
@@ -402,6 +664,12 @@ class PrimaryGenerator : public G4VPrimaryGenerator {
         /** List of files with generator data. */
         std::vector<std::string> files_;
 
+        /** The file that is currently open. */
+        std::string currentFile_;
+
+        /** Key of the event cache of the current file (empty if there is no cache). */
+        std::string cacheKey_;
+
         /** File processing queue. */
         std::queue<std::string> fileQueue_;
 
@@ -411,14 +679,35 @@ class PrimaryGenerator : public G4VPrimaryGenerator {
         /** List of transforms that are applied to the events from this generator. */
         std::vector<VertexTransform*> transforms_;
 
+        /** The transforms compiled into a single pass. */
+        FusedVertexTransform fusedTransform_;
+
+        /** Alias table over the cached event weights for the weighted read mode. */
+        AliasTable aliasTable_;
+
+        /** Flag set when the deterministic transforms were applied to the event cache. */
+        bool cacheTransformed_{false};
+
         /** The event sampling for getting the number of events to overlay (default of 1). */
         EventSampling* sampling_{new UniformEventSampling};
 
+        /** Pre-drawn number of events to sample for each event ID in the run (empty when not planned). */
+        std::vector<int> samplingPlan_;
+
+        /** Total number of events in the sampling plan. */
+        long plannedDemand_{-1};
+
         /** Access to simple key-value double parameters set from steering macros. */
         Parameters params_;
 
         /** The read mode of the generator: either sequential or random. */
         ReadMode readMode_{Sequential};
+
+        /** The read mode which was set, restored at each run after a fall back to sequential reading. */
+        ReadMode userReadMode_{Sequential};
+
+        /** Flag set when the event cache did not fit in the memory budget and the run was aborted. */
+        bool cacheOverBudget_{false};
  
         /* Flag that controls whether generator rereads the same event (e.g. for biasing). */
         bool readFlag_{true};
@@ -11,6 +11,7 @@
 #include "G4VPrimaryGenerator.hh"
 #include "G4Event.hh"
 #include "G4RunManager.hh"
+#include "G4Run.hh"
 
 #include "PGAMessenger.h"
 #include "UserPrimaryParticleInformation.h"
@@ -66,7 +67,13 @@ class PrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction {
         /**
          * Initialize all PrimaryGenerator objects before run starts.
          */
-        void initialize();
+        void initialize(const G4Run* aRun);
+
+        /**
+         * Turn on pre-drawing of the number of events to sample from each generator
+         * at the start of the run.
+         */
+        void setPlanSampling(bool planSampling);
 
         void endEvent(const G4Event*);
 
@@ -102,6 +109,12 @@ class PrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction {
          */
         void doNextRead(hpssim::PrimaryGenerator* gen);
 
+        /**
+         * Pre-draw the number of events to sample from every generator for each event in the run
+         * and check that the generator input files have enough events.
+         */
+        void planSampling(const G4Run* aRun);
+
     protected:
 
         /** Verbose level with access for sub-classes. */
@@ -114,6 +127,9 @@ class PrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction {
 
         /** List of primary generators to run for every Geant4 event. */
         std::vector<PrimaryGenerator*> generators_;
+
+        /** Flag to plan the event sampling for the run. */
+        bool planSampling_{false};
     
 };
 
@@ -45,6 +45,7 @@ class PrimaryGeneratorMessenger : public G4UImessenger {
         G4UIcommand* sequentialCmd_;
         G4UIcommand* linearCmd_;
         G4UIcommand* semiRandomCmd_;
+        G4UIcommand* weightedCmd_;
 };
 
 }
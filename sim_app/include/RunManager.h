@@ -17,7 +17,11 @@
  */
 #include "LcioPersistencyManager.h"
 #include "PluginManager.h"
+#include "MemoryBudgetMessenger.h"
 #include "PhysicsMessenger.h"
+#include "TrajectoryPointMessenger.h"
+#include "TrajectoryStorageMessenger.h"
+#include "VolumeTagsMessenger.h"
 
 namespace hpssim {
 
@@ -87,6 +91,32 @@ class RunManager: public G4RunManager {
          */
         G4UImessenger* physicsMessenger_{nullptr};
 
+        /**
+         * Messenger for the memory budget of the caches.
+         */
+        G4UImessenger* memoryMessenger_{nullptr};
+
+        /**
+         * Messenger for the points stored in trajectories.
+         */
+        G4UImessenger* trajectoryMessenger_{nullptr};
+
+        /**
+         * Messenger for the trajectory storage rules.
+         */
+        G4UImessenger* storageMessenger_{nullptr};
+
+        /**
+         * Messenger for the volume tags.
+         */
+        G4UImessenger* volumesMessenger_{nullptr};
+
+        /**
+         * User actions which are only installed while plugins use them.
+         */
+        G4UserSteppingAction* steppingAction_{nullptr};
+        G4UserStackingAction* stackingAction_{nullptr};
+
         /**
          * Factory class for instantiating the physics list.
          */
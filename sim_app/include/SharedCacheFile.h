@@ -0,0 +1,317 @@
+/**
+ * @file SharedCacheFile.h
+ * @brief Class for publishing a generator event cache in a memory mapped file
+ */
+
+#ifndef HPSSIM_SHAREDCACHEFILE_H_
+#define HPSSIM_SHAREDCACHEFILE_H_
+
+#include "globals.hh"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+
+namespace hpssim {
+
+/**
+ * @class SharedCacheFile
+ * @brief A memory mapped file in a shared memory directory holding the data of one event cache
+ *
+ * @note
+ * The file is named from a hash of the cache key, which is stored in the file to check for collisions.
+ * Processes which use the data hold a shared lock on the file, and the process which builds the data
+ * holds an exclusive lock until it is complete, which other processes wait for with a shared lock.
+ * If the builder dies, the lock is released and the incomplete file is rebuilt by the next process
+ * that opens it.  The last process to release the
+ * file removes it.  The directory should be on tmpfs (e.g. /dev/shm) or hugetlbfs, in which case
+ * the file size is rounded up to the huge page size.
+ */
+class SharedCacheFile {
+
+    public:
+
+        /**
+         * Open the file for a cache key, waiting while another process builds it.
+         * @return The file or null if it cannot be used, in which case the caller should
+         * keep a private cache.  If the file is not complete, the caller must build it
+         * with allocate() and publish().
+         */
+        static std::shared_ptr<SharedCacheFile> open(const std::string& dir, const std::string& key) {
+            std::ostringstream path;
+            path << dir << "/hps-sim-cache-" << std::hex << std::setw(16) << std::setfill('0')
+                    << std::hash<std::string>()(key);
+            std::shared_ptr<SharedCacheFile> file(new SharedCacheFile(path.str(), key));
+            if (!file->lock()) {
+                return nullptr;
+            }
+            return file;
+        }
+
+        ~SharedCacheFile() {
+            if (header_) {
+                munmap(header_, mappedSize_);
+            }
+            if (fd_ >= 0) {
+                // Remove the file if no other process is using it and it was not replaced.
+                if (!flock(fd_, LOCK_EX | LOCK_NB)) {
+                    struct stat fileInfo, pathInfo;
+                    if (!fstat(fd_, &fileInfo) && !stat(path_.c_str(), &pathInfo) && fileInfo.st_ino == pathInfo.st_ino) {
+                        unlink(path_.c_str());
+                    }
+                }
+                close(fd_);
+            }
+        }
+
+        /**
+         * Return true if the data is complete and mapped read-only.
+         */
+        bool isComplete() const {
+            return complete_;
+        }
+
+        /**
+         * Allocate and map the data of an incomplete file for writing.
+         * @return The data or null if the file could not be allocated.
+         */
+        char* allocate(size_t dataSize) {
+            if (complete_ || header_) {
+                return nullptr;
+            }
+            size_t dataOffset = align(sizeof(Header) + key_.size() + 1);
+            size_t size = dataOffset + dataSize;
+            struct statfs fsInfo;
+            if (!fstatfs(fd_, &fsInfo) && fsInfo.f_bsize > 0) {
+                size = (size + fsInfo.f_bsize - 1) / fsInfo.f_bsize * fsInfo.f_bsize;
+            }
+            if (ftruncate(fd_, 0) || ftruncate(fd_, size)) {
+                warning("Failed to allocate shared cache file '" + path_ + "'.");
+                return nullptr;
+            }
+            void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+            if (addr == MAP_FAILED) {
+                warning("Failed to map shared cache file '" + path_ + "'.");
+                return nullptr;
+            }
+            header_ = static_cast<Header*>(addr);
+            mappedSize_ = size;
+            std::memcpy(header_->magic, magic(), sizeof(header_->magic));
+            header_->complete = 0;
+            header_->keySize = key_.size();
+            header_->dataOffset = dataOffset;
+            header_->dataSize = dataSize;
+            std::memcpy(reinterpret_cast<char*>(header_ + 1), key_.c_str(), key_.size() + 1);
+            return getData();
+        }
+
+        /**
+         * Mark the data as complete, make it read-only and let other processes attach to it.
+         */
+        void publish() {
+            if (!header_ || complete_) {
+                return;
+            }
+            __sync_synchronize();
+            header_->complete = 1;
+            msync(header_, mappedSize_, MS_ASYNC);
+            mprotect(header_, mappedSize_, PROT_READ);
+            flock(fd_, LOCK_SH);
+            complete_ = true;
+        }
+
+        char* getData() const {
+            return header_ ? reinterpret_cast<char*>(header_) + header_->dataOffset : nullptr;
+        }
+
+        size_t getDataSize() const {
+            return header_ ? header_->dataSize : 0;
+        }
+
+        const std::string& getPath() const {
+            return path_;
+        }
+
+        /**
+         * Round up an offset so that any record type can be mapped at it.
+         */
+        static size_t align(size_t offset) {
+            return (offset + 63) & ~size_t(63);
+        }
+
+        /**
+         * Copy an array into the data at an offset, or only advance the offset if the data is null.
+         */
+        template<class T>
+        static void pack(char* data, size_t& offset, const T* values, size_t n) {
+            offset = align(offset);
+            if (data && n) {
+                std::memcpy(data + offset, values, n * sizeof(T));
+            }
+            offset += n * sizeof(T);
+        }
+
+        /**
+         * Get an array from the data at an offset.
+         */
+        template<class T>
+        static const T* map(const char* data, size_t& offset, size_t n) {
+            offset = align(offset);
+            const T* values = reinterpret_cast<const T*>(data + offset);
+            offset += n * sizeof(T);
+            return values;
+        }
+
+    private:
+
+        struct Header {
+            char magic[8];
+            uint64_t complete;
+            uint64_t keySize;
+            uint64_t dataOffset;
+            uint64_t dataSize;
+        };
+
+        /** Possible states of the file when it is opened. */
+        enum State {
+            Empty,
+            Complete,
+            Conflict
+        };
+
+        /** Number of times to try to lock the file before using a private cache. */
+        static const int MAX_LOCK_ATTEMPTS = 1000;
+
+        static const char* magic() {
+            return "HPSCACH1";
+        }
+
+        SharedCacheFile(const std::string& path, const std::string& key) :
+                path_(path), key_(key) {
+        }
+
+        /**
+         * Open and lock the file and map it if it is complete.
+         *
+         * @note
+         * A shared lock is never converted to an exclusive one while waiting, because Linux
+         * releases the shared lock first, so a process waiting for the exclusive lock would be
+         * blocked by every process which has attached to the complete file.  Instead, a process
+         * which finds the file empty releases its lock and only tries to get the exclusive lock.
+         * If another process holds it, the process waits for a shared lock, which it gets as soon
+         * as the builder publishes the file, and checks the file again.
+         */
+        bool lock() {
+            fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT, 0644);
+            if (fd_ < 0) {
+                warning("Failed to open shared cache file '" + path_ + "'.");
+                return false;
+            }
+            // Seeded by the process so processes which raced do not back off in lockstep.
+            std::minstd_rand backoff(getpid());
+            for (int attempt = 0; attempt < MAX_LOCK_ATTEMPTS; attempt++) {
+                if (flock(fd_, LOCK_SH)) {
+                    warning("Failed to lock shared cache file '" + path_ + "'.");
+                    return false;
+                }
+                State state = attach();
+                if (state == Empty) {
+                    flock(fd_, LOCK_UN);
+                    if (!flock(fd_, LOCK_EX | LOCK_NB)) {
+                        // Check again in case another process built it before the lock was released.
+                        state = attach();
+                        if (state == Complete) {
+                            flock(fd_, LOCK_SH);
+                        } else if (state == Empty) {
+                            // This process builds the data.
+                            return true;
+                        }
+                    } else if (errno != EWOULDBLOCK) {
+                        warning("Failed to lock shared cache file '" + path_ + "'.");
+                        return false;
+                    } else {
+                        // Another process is building the data or also found the file empty.
+                        if (flock(fd_, LOCK_SH)) {
+                            warning("Failed to lock shared cache file '" + path_ + "'.");
+                            return false;
+                        }
+                        state = attach();
+                        if (state == Empty) {
+                            // Back off for a random time so processes which raced do not retry together.
+                            flock(fd_, LOCK_UN);
+                            usleep(1000 + backoff() % 10000);
+                            continue;
+                        }
+                    }
+                }
+                if (state == Conflict) {
+                    warning("Shared cache file '" + path_ + "' belongs to a different cache.");
+                    return false;
+                }
+                return true;
+            }
+            warning("Timed out waiting for shared cache file '" + path_ + "'.");
+            return false;
+        }
+
+        /**
+         * Map the file read-only if it holds complete data for the key.
+         */
+        State attach() {
+            struct stat info;
+            if (fstat(fd_, &info) || (size_t) info.st_size < sizeof(Header)) {
+                return Empty;
+            }
+            void* addr = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd_, 0);
+            if (addr == MAP_FAILED) {
+                return Empty;
+            }
+            Header* header = static_cast<Header*>(addr);
+            const char* key = reinterpret_cast<const char*>(header + 1);
+            if (std::memcmp(header->magic, magic(), sizeof(header->magic)) || !header->complete
+                    || header->dataOffset + header->dataSize > (size_t) info.st_size) {
+                // Left incomplete by a process that failed while building it.
+                munmap(addr, info.st_size);
+                return Empty;
+            }
+            if (header->keySize != key_.size() || key_.compare(0, std::string::npos, key, header->keySize)) {
+                munmap(addr, info.st_size);
+                return Conflict;
+            }
+            header_ = header;
+            mappedSize_ = info.st_size;
+            complete_ = true;
+            return Complete;
+        }
+
+        void warning(const std::string& message) {
+            G4Exception("SharedCacheFile", "", JustWarning, message.c_str());
+        }
+
+    private:
+
+        std::string path_;
+        std::string key_;
+
+        int fd_{-1};
+        Header* header_{nullptr};
+        size_t mappedSize_{0};
+        bool complete_{false};
+};
+
+}
+
+#endif
@@ -14,6 +14,7 @@
 #include "G4ClassificationOfNewTrack.hh"
 
 #include "Parameters.h"
+#include "VolumeTags.h"
 
 #include <vector>
 
@@ -41,7 +42,24 @@ class SimPlugin {
             STACKING,
             STEPPING,
             TRACKING,
-            PRIMARY
+            PRIMARY,
+            STAGING
+        };
+
+        /**
+         * Conditions on the steps which are passed to the stepping action of a plugin.
+         * Conditions which are not set match any step.
+         */
+        struct SteppingFilter {
+
+                /** PDG codes of the particles (empty for any). */
+                std::vector<int> pdgCodes;
+
+                /** Tags of the volume at the pre-step point (0 for any). */
+                VolumeTags::Mask volumeTags{0};
+
+                /** True to only pass steps which end on a volume boundary. */
+                bool boundaryOnly{false};
         };
 
         /**
@@ -64,6 +82,17 @@ class SimPlugin {
          */
         virtual std::vector<PluginAction> getActions() = 0;
 
+        /**
+         * Get the conditions on the steps passed to the stepping action.
+         * The plugin manager checks them before calling the plugin, so plugins which only
+         * need some particles or volumes are not called for every step.  This is read after
+         * initialize(), so volume tags defined there can be used.
+         * @return The stepping filter, which passes all steps by default.
+         */
+        virtual SteppingFilter getSteppingFilter() {
+            return SteppingFilter();
+        }
+
         /**
          * Set the verbose level of the plugin (1-4).
          * @param verbose The verbose level of the plugin.
@@ -167,6 +196,25 @@ class SimPlugin {
         virtual void stackingPrepareNewEvent() {
         }
 
+        /**
+         * Return true if a new track is simulated in the first stage of the event.
+         * Tracks which no staging plugin puts in the first stage are postponed until
+         * the staging plugins have accepted the event.
+         * @return False by default.
+         */
+        virtual bool stagingIsFirstStage(const G4Track*) {
+            return false;
+        }
+
+        /**
+         * Decide whether to keep the event when a stage is finished.
+         * @param stage The stage which is finished, starting from 0.
+         * @return False to abort the event before the postponed tracks are simulated.
+         */
+        virtual bool stagingAcceptEvent(int) {
+            return true;
+        }
+
     protected:
 
         /** Protected access to verbose level for convenience of sub-classes. */
@@ -179,7 +227,16 @@ class SimPlugin {
 
 /*
 * Macro for defining the create and destroy methods for a sim plugin.
+* When the plugins are linked into the application, it registers them
+* in the PluginRegistry instead.
 */
+#ifdef HPSSIM_STATIC_PLUGINS
+#include "PluginRegistry.h"
+#define SIM_PLUGIN(NS, NAME) \
+static hpssim::PluginRegistration NAME ## Registration(#NAME, \
+[]() -> hpssim::SimPlugin* { return new NS::NAME; }, \
+[](hpssim::SimPlugin* object) { delete object; });
+#else
 #define SIM_PLUGIN(NS, NAME) \
 extern "C" NS::NAME* create ## NAME() { \
 return new NS::NAME; \
@@ -187,5 +244,6 @@ return new NS::NAME; \
 extern "C" void destroy ## NAME(NS::NAME* object) { \
 delete object; \
 }
+#endif
 
 #endif
@@ -21,8 +21,9 @@ class SimPlugin;
  *
  * @note
  * By default, this class creates a directory for the plugin and provides
- * a command for setting of the verbose level.  Users can override this
- * class to provide additional commands for their specific plugins.
+ * commands for setting the verbose level and the double parameters.  Users
+ * can override this class to provide additional commands for their specific
+ * plugins.
  *
  * @note
  * This class is not automatically created within a SimPlugin.  Instead, within
@@ -44,6 +45,7 @@ class SimPluginMessenger : public G4UImessenger {
          */
         virtual ~SimPluginMessenger() {
             delete verboseCmd_;
+            delete paramCmd_;
             delete pluginDir_;
         }
 
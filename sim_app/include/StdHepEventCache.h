@@ -0,0 +1,404 @@
+/**
+ * @file StdHepEventCache.h
+ * @brief Class for caching the events of a StdHep file for random access
+ */
+
+#ifndef HPSSIM_STDHEPEVENTCACHE_H_
+#define HPSSIM_STDHEPEVENTCACHE_H_
+
+#include "globals.hh"
+
+#include "lStdHep.h"
+#include "SharedCacheFile.h"
+#include "VertexTransform.h"
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace hpssim {
+
+/**
+ * @class StdHepEventCache
+ * @brief Cache of StdHep events with either a full or a compact memory layout
+ *
+ * @note
+ * The full layout keeps a copy of every lStdEvent.  The compact layout stores the tracks
+ * of all events in one structure of arrays with an event offset table.  Kinematics are
+ * stored as floats, and the energy is recomputed in double precision from the momentum
+ * and mass when an event is read back.  Parent and daughter links are stored as the track
+ * index plus one (the value modulo 10000), which is all the generator uses.  The compact
+ * layout can be packed into a SharedCacheFile and used from there by other processes.
+ */
+class StdHepEventCache {
+
+    public:
+
+        enum Layout {
+            Full,
+            Compact
+        };
+
+        StdHepEventCache() {
+            offsets_.push_back(0);
+        }
+
+        void setLayout(Layout layout) {
+            if (size()) {
+                G4Exception("StdHepEventCache::setLayout", "", FatalException,
+                        "The layout cannot be changed when the cache has events.");
+            }
+            layout_ = layout;
+        }
+
+        Layout getLayout() const {
+            return layout_;
+        }
+
+        long size() const {
+            if (layout_ == Full) {
+                return records_.size();
+            }
+            return offsets_.size() - 1;
+        }
+
+        void clear() {
+            file_.reset();
+            records_.clear();
+            records_.shrink_to_fit();
+            offsets_.clear();
+            offsets_.push_back(0);
+            evtNum_.clear();
+            x_.clear();
+            y_.clear();
+            z_.clear();
+            t_.clear();
+            px_.clear();
+            py_.clear();
+            pz_.clear();
+            m_.clear();
+            pid_.clear();
+            status_.clear();
+            mother1_.clear();
+            mother2_.clear();
+            daughter1_.clear();
+            daughter2_.clear();
+        }
+
+        /**
+         * Add an event to the end of the cache.
+         */
+        void addEvent(const lStdEvent& event) {
+            if (layout_ == Full) {
+                records_.push_back(event);
+                return;
+            }
+            evtNum_.push_back(event.evtNum);
+            for (auto& track : event) {
+                x_.push_back(track.X);
+                y_.push_back(track.Y);
+                z_.push_back(track.Z);
+                t_.push_back(track.T);
+                px_.push_back(track.Px);
+                py_.push_back(track.Py);
+                pz_.push_back(track.Pz);
+                m_.push_back(track.M);
+                pid_.push_back(track.pid);
+                status_.push_back(track.status);
+                mother1_.push_back(track.mother1 % 10000);
+                mother2_.push_back(track.mother2 % 10000);
+                daughter1_.push_back(track.daughter1 % 10000);
+                daughter2_.push_back(track.daughter2 % 10000);
+            }
+            offsets_.push_back(x_.size());
+        }
+
+        /**
+         * Convert the events in the full layout to the compact layout.
+         */
+        void compact() {
+            if (layout_ == Compact) {
+                return;
+            }
+            std::vector<lStdEvent> records;
+            records.swap(records_);
+            layout_ = Compact;
+            for (auto& record : records) {
+                addEvent(record);
+                lStdEvent().swap(record);
+            }
+            shrink();
+        }
+
+        /**
+         * Release unused capacity once the cache is filled.
+         */
+        void shrink() {
+            records_.shrink_to_fit();
+            offsets_.shrink_to_fit();
+            evtNum_.shrink_to_fit();
+            x_.shrink_to_fit();
+            y_.shrink_to_fit();
+            z_.shrink_to_fit();
+            t_.shrink_to_fit();
+            px_.shrink_to_fit();
+            py_.shrink_to_fit();
+            pz_.shrink_to_fit();
+            m_.shrink_to_fit();
+            pid_.shrink_to_fit();
+            status_.shrink_to_fit();
+            mother1_.shrink_to_fit();
+            mother2_.shrink_to_fit();
+            daughter1_.shrink_to_fit();
+            daughter2_.shrink_to_fit();
+        }
+
+        /**
+         * Copy an event from the cache.
+         */
+        void getEvent(long index, lStdEvent& event) const {
+            if (layout_ == Full) {
+                event = records_[index];
+                return;
+            }
+            uint32_t begin = offsets_[index];
+            uint32_t end = offsets_[index + 1];
+            event.resize(end - begin);
+            event.evtNum = evtNum_[index];
+            for (uint32_t i = begin; i < end; i++) {
+                lStdTrack& track = event[i - begin];
+                track.X = x_[i];
+                track.Y = y_[i];
+                track.Z = z_[i];
+                track.T = t_[i];
+                track.Px = px_[i];
+                track.Py = py_[i];
+                track.Pz = pz_[i];
+                track.M = m_[i];
+                track.E = std::sqrt(track.Px * track.Px + track.Py * track.Py + track.Pz * track.Pz + track.M * track.M);
+                track.pid = pid_[i];
+                track.status = status_[i];
+                track.mother1 = mother1_[i];
+                track.mother2 = mother2_[i];
+                track.daughter1 = daughter1_[i];
+                track.daughter2 = daughter2_[i];
+            }
+        }
+
+        /**
+         * Remove an event from the cache, which is only supported by the full layout.
+         */
+        void removeEvent(long index) {
+            if (layout_ != Full) {
+                G4Exception("StdHepEventCache::removeEvent", "", FatalException,
+                        "Removing events is not supported by the compact cache.");
+            }
+            records_.erase(records_.begin() + index);
+        }
+
+        /**
+         * Apply the deterministic part of a transform to the positions and momenta of all tracks.
+         */
+        void transform(const FusedVertexTransform& transform) {
+            if (layout_ == Full) {
+                for (auto& record : records_) {
+                    for (auto& track : record) {
+                        G4ThreeVector pos = transform.mapPosition(G4ThreeVector(track.X, track.Y, track.Z));
+                        track.X = pos.x();
+                        track.Y = pos.y();
+                        track.Z = pos.z();
+                        G4ThreeVector p = transform.mapMomentum(G4ThreeVector(track.Px, track.Py, track.Pz));
+                        track.Px = p.x();
+                        track.Py = p.y();
+                        track.Pz = p.z();
+                    }
+                }
+                return;
+            }
+            for (size_t i = 0; i < x_.size(); i++) {
+                G4ThreeVector pos = transform.mapPosition(G4ThreeVector(x_[i], y_[i], z_[i]));
+                x_.at(i) = pos.x();
+                y_.at(i) = pos.y();
+                z_.at(i) = pos.z();
+                G4ThreeVector p = transform.mapMomentum(G4ThreeVector(px_[i], py_[i], pz_[i]));
+                px_.at(i) = p.x();
+                py_.at(i) = p.y();
+                pz_.at(i) = p.z();
+            }
+        }
+
+        /**
+         * Pack the compact layout into the data of a shared file.
+         * @param data The data to write or null to only compute the size.
+         * @return The size of the packed data.
+         */
+        size_t pack(char* data) const {
+            if (layout_ != Compact) {
+                G4Exception("StdHepEventCache::pack", "", FatalException,
+                        "Only the compact cache can be packed into a shared file.");
+            }
+            uint64_t counts[2] = {offsets_.size(), x_.size()};
+            size_t offset = 0;
+            SharedCacheFile::pack(data, offset, counts, 2);
+            offsets_.pack(data, offset);
+            evtNum_.pack(data, offset);
+            x_.pack(data, offset);
+            y_.pack(data, offset);
+            z_.pack(data, offset);
+            t_.pack(data, offset);
+            px_.pack(data, offset);
+            py_.pack(data, offset);
+            pz_.pack(data, offset);
+            m_.pack(data, offset);
+            pid_.pack(data, offset);
+            status_.pack(data, offset);
+            mother1_.pack(data, offset);
+            mother2_.pack(data, offset);
+            daughter1_.pack(data, offset);
+            daughter2_.pack(data, offset);
+            return offset;
+        }
+
+        /**
+         * Use the compact layout packed in a complete shared file instead of the data in this cache.
+         */
+        void map(std::shared_ptr<SharedCacheFile> file) {
+            clear();
+            layout_ = Compact;
+            const char* data = file->getData();
+            size_t offset = 0;
+            const uint64_t* counts = SharedCacheFile::map<uint64_t>(data, offset, 2);
+            size_t nOffsets = counts[0];
+            size_t nTracks = counts[1];
+            offsets_.map(data, offset, nOffsets);
+            evtNum_.map(data, offset, nOffsets - 1);
+            x_.map(data, offset, nTracks);
+            y_.map(data, offset, nTracks);
+            z_.map(data, offset, nTracks);
+            t_.map(data, offset, nTracks);
+            px_.map(data, offset, nTracks);
+            py_.map(data, offset, nTracks);
+            pz_.map(data, offset, nTracks);
+            m_.map(data, offset, nTracks);
+            pid_.map(data, offset, nTracks);
+            status_.map(data, offset, nTracks);
+            mother1_.map(data, offset, nTracks);
+            mother2_.map(data, offset, nTracks);
+            daughter1_.map(data, offset, nTracks);
+            daughter2_.map(data, offset, nTracks);
+            file_ = file;
+        }
+
+        /**
+         * Get the approximate number of bytes used by the cached data, not counting a shared file.
+         */
+        size_t getMemoryUsage() const {
+            if (layout_ == Full) {
+                size_t bytes = records_.capacity() * sizeof(lStdEvent);
+                for (auto& record : records_) {
+                    bytes += record.capacity() * sizeof(lStdTrack);
+                }
+                return bytes;
+            }
+            return offsets_.capacity() * sizeof(uint32_t) + evtNum_.capacity() * sizeof(int32_t)
+                    + x_.capacity() * (8 * sizeof(float) + sizeof(int32_t) + sizeof(int16_t) + 4 * sizeof(uint16_t));
+        }
+
+    private:
+
+        /**
+         * Array of the compact layout which is either owned or mapped from a shared file.
+         */
+        template<class T>
+        class Column {
+
+            public:
+
+                T operator[](size_t i) const {
+                    return mapped_ ? mapped_[i] : values_[i];
+                }
+
+                /**
+                 * Get a value for modification, which is only possible if the column is not mapped.
+                 */
+                T& at(size_t i) {
+                    return values_[i];
+                }
+
+                void push_back(T value) {
+                    values_.push_back(value);
+                }
+
+                size_t size() const {
+                    return mapped_ ? nMapped_ : values_.size();
+                }
+
+                size_t capacity() const {
+                    return values_.capacity();
+                }
+
+                void clear() {
+                    values_.clear();
+                    mapped_ = nullptr;
+                    nMapped_ = 0;
+                }
+
+                void shrink_to_fit() {
+                    values_.shrink_to_fit();
+                }
+
+                void pack(char* data, size_t& offset) const {
+                    SharedCacheFile::pack(data, offset, values_.data(), values_.size());
+                }
+
+                void map(const char* data, size_t& offset, size_t n) {
+                    values_.clear();
+                    values_.shrink_to_fit();
+                    mapped_ = SharedCacheFile::map<T>(data, offset, n);
+                    nMapped_ = n;
+                }
+
+            private:
+
+                std::vector<T> values_;
+                const T* mapped_{nullptr};
+                size_t nMapped_{0};
+        };
+
+    private:
+
+        Layout layout_{Full};
+
+        /** Events in the full layout. */
+        std::vector<lStdEvent> records_;
+
+        /** Index of the first track of each event plus the end of the last event (compact layout). */
+        Column<uint32_t> offsets_;
+
+        /** Event numbers (compact layout). */
+        Column<int32_t> evtNum_;
+
+        /** Track data (compact layout). */
+        Column<float> x_;
+        Column<float> y_;
+        Column<float> z_;
+        Column<float> t_;
+        Column<float> px_;
+        Column<float> py_;
+        Column<float> pz_;
+        Column<float> m_;
+        Column<int32_t> pid_;
+        Column<int16_t> status_;
+        Column<uint16_t> mother1_;
+        Column<uint16_t> mother2_;
+        Column<uint16_t> daughter1_;
+        Column<uint16_t> daughter2_;
+
+        /** The shared file with the compact layout when it is mapped. */
+        std::shared_ptr<SharedCacheFile> file_;
+};
+
+}
+
+#endif
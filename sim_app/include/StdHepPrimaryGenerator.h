@@ -13,9 +13,12 @@
 #include "G4PhysicalConstants.hh"
 
 #include "lStdHep.h"
+#include "GeneratorCacheRegistry.h"
+#include "StdHepEventCache.h"
 #include "StdHepParticle.h"
 #include "PrimaryGenerator.h"
 
+#include <memory>
 #include <vector>
 
 namespace hpssim {
@@ -23,6 +26,15 @@ namespace hpssim {
 /**
  * @class STDHEPPrimaryGenerator
  * @brief Generates a Geant4 event from StdHep data
+ *
+ * @par
+ * Setting the parameter <i>compactCache</i> to 1 selects the compact layout of the event cache,
+ * which stores kinematics as floats to reduce memory usage for large files.
+ *
+ * @par
+ * The event cache is shared through the GeneratorCacheRegistry with other StdHep generators
+ * that read the same file with the same cache layout and deterministic transforms.  The compact
+ * layout is also shared with other processes if a shared memory directory is set.
  */
 class StdHepPrimaryGenerator : public PrimaryGenerator {
 
@@ -163,13 +175,14 @@ class StdHepPrimaryGenerator : public PrimaryGenerator {
         }
 
         int getNumEvents() {
-            return records_.size();
+            return cache_ ? cache_->size() : 0;
         }
 
         /**
-         * Cache a list of events for random access.
-         * The StdHep data is copied so pointers are not used in the event vector.
-         * Memory will be reclaimed when the vector is cleared.
+         * Cache a list of events for random access, or get the cache from the registry
+         * if another generator has already read the file.
+         * The StdHep data is copied so pointers are not used in the event cache.
+         * Memory will be reclaimed when the last generator using the cache releases it.
          */
         void cacheEvents() {
 
@@ -177,14 +190,45 @@ class StdHepPrimaryGenerator : public PrimaryGenerator {
           if (verbose_ > 1) {
             std::cout << "StdHepPrimaryGenerator::cacheEvents -- Start caching events. " << std::endl;
           }
-            // Clear record cache.
-            if (records_.size()) {
-                records_.clear();
+            // Release the cache of the previous file.
+            cache_.reset();
+            ownCache_.reset();
+
+            StdHepEventCache::Layout layout = getCacheLayout();
+            const FusedVertexTransform* transform = getCacheTransform();
+            std::string key = getCacheKey();
+
+            cache_ = GeneratorCacheRegistry::getRegistry()->find<StdHepEventCache>(key);
+            if (cache_) {
+                if (verbose_ > 1) {
+                    std::cout << "StdHepPrimaryGenerator: Using shared cache with " << cache_->size() << " records" << std::endl;
+                }
+                return;
             }
 
-            // Cache a list of StdHep events.
+            // Attach to a cache built by another process or build it for them (compact layout only).
+            std::shared_ptr<SharedCacheFile> file;
+            if (layout == StdHepEventCache::Compact) {
+                file = GeneratorCacheRegistry::getRegistry()->openSharedFile(key);
+            }
+            if (file && file->isComplete()) {
+                auto cache = std::make_shared<StdHepEventCache>();
+                cache->map(file);
+                cache_ = cache;
+                GeneratorCacheRegistry::getRegistry()->add(key, cache_);
+                if (verbose_ > 1) {
+                    std::cout << "StdHepPrimaryGenerator: Using shared memory cache with " << cache_->size() << " records" << std::endl;
+                }
+                return;
+            }
+
+            auto cache = std::make_shared<StdHepEventCache>();
+            cache->setLayout(layout);
+
+            // Cache a list of StdHep events, checking the memory budget every so often.
+            lStdEvent lse;
+            MemoryBudget* budget = MemoryBudget::getBudget();
             while (true) {
-                lStdEvent lse;
                 long res = reader_->readEvent(lse);
                 if (res == LSH_ENDOFFILE) {
                     break;
@@ -192,14 +236,58 @@ class StdHepPrimaryGenerator : public PrimaryGenerator {
                     std::cerr << "StdHepPrimaryGenerator: Got non-zero LSH error code " << res << std::endl;
                     G4Exception("", "", FatalException, "Error reading StdHep file.");
                 }
-                records_.push_back(lse);
+                cache->addEvent(lse);
+                if (cache->size() % 1000 == 0 && !budget->fits(key, cache->getMemoryUsage())) {
+                    if (cache->getLayout() == StdHepEventCache::Full) {
+                        G4Exception("StdHepPrimaryGenerator::cacheEvents", "", JustWarning,
+                                G4String("Using the compact cache layout for '" + getName() + "' to fit in the memory budget."));
+                        cache->compact();
+                    }
+                    if (!budget->fits(key, cache->getMemoryUsage())) {
+                        fallBackToSequential();
+                        return;
+                    }
+                }
+            }
+            cache->shrink();
+
+            /*
+             * Apply the deterministic transforms to the positions and momenta of the cached tracks.
+             * Positions are used without unit conversion, and momentum rotation does not depend
+             * on the momentum units.
+             */
+            if (transform) {
+                cache->transform(*transform);
+            }
+
+            if (file) {
+                cache = GeneratorCacheRegistry::publish(file, cache);
             }
 
+            cache_ = GeneratorCacheRegistry::account(key, cache, cache->getMemoryUsage());
+            GeneratorCacheRegistry::getRegistry()->add(key, cache_);
+
             if (verbose_ > 1) {
-                std::cout << "StdHepPrimaryGenerator: Cached " << records_.size() << " records for random access" << std::endl;
+                std::cout << "StdHepPrimaryGenerator: Cached " << cache_->size() << " records for random access using "
+                        << cache_->getMemoryUsage() << " bytes" << std::endl;
             }
         }
 
+        bool supportsCacheTransform() {
+            return true;
+        }
+
+        std::string getCacheKey() {
+            const FusedVertexTransform* transform = getCacheTransform();
+            return GeneratorCacheRegistry::makeKey("StdHep", getCurrentFile(),
+                    std::to_string(getCacheLayout()) + ":" + (transform ? transform->getFingerprint() : ""));
+        }
+
+        long getFileEventCount(std::string file) {
+            lStdHep reader(file.c_str());
+            return reader.numEvents();
+        }
+
         void readNextEvent() throw(EndOfFileException) {
             long res = reader_->readEvent(stdEvent_);
             if (res == LSH_ENDOFFILE) {
@@ -224,19 +312,34 @@ class StdHepPrimaryGenerator : public PrimaryGenerator {
 
         void readEvent(long index, bool removeEvent) throw(NoSuchRecordException) {
             // TODO: check validity of index
-            stdEvent_ = records_[index];
+            cache_->getEvent(index, stdEvent_);
             if (removeEvent) {
               std::cerr << "Erasing from a vector is a really bad idea. See: http://www.cplusplus.com/reference/vector/vector/erase/" << std::endl;
-              records_.erase(records_.begin() + index);
+              if (!ownCache_) {
+                  // Copy the shared cache before modifying it.
+                  ownCache_ = std::make_shared<StdHepEventCache>(*cache_);
+                  cache_ = ownCache_;
+              }
+              ownCache_->removeEvent(index);
             }
         }
 
+    private:
+
+        StdHepEventCache::Layout getCacheLayout() {
+            return getParameters().get("compactCache", 0.) ? StdHepEventCache::Compact : StdHepEventCache::Full;
+        }
+
     private:
 
         lStdHep* reader_{nullptr};
         lStdEvent stdEvent_;
 
-        std::vector<lStdEvent> records_;
+        /** The event cache, which may be shared with other generators. */
+        std::shared_ptr<const StdHepEventCache> cache_;
+
+        /** Private copy of the cache when events have been removed from it. */
+        std::shared_ptr<StdHepEventCache> ownCache_;
 };
 
 }
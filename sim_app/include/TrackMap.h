@@ -18,6 +18,9 @@
  */
 #include "Trajectory.h"
 
+#include <algorithm>
+#include <vector>
+
 namespace hpssim {
 
 /**
@@ -28,23 +31,42 @@ namespace hpssim {
  * This class provides a record of track ancestry which is used
  * to connect track IDs to their parents.  It also maps track IDs
  * to Trajectory objects.
+ *
+ * @par
+ * Geant4 assigns track IDs densely from 1, so the records are kept in a vector
+ * indexed by the track ID.  Records are tagged with the generation of the map, which
+ * is incremented to clear the map at the start of each event without visiting them.
+ * The nearest ancestor with a trajectory is remembered for every track visited by
+ * findTrajectory, so looking up many hits from the same shower is amortized O(1).
+ * These results are invalidated whenever a trajectory is added.
  */
 class TrackMap {
 
     public:
 
-        /**
-         * Map of track ID to parent ID.
-         */
-        typedef std::map<G4int, G4int> TrackIDMap;
-
         /**
          * Add a record in the map connecting a track ID to its parent ID.
          * @param trackID The track ID.
          * @param parentID The parent track ID.
          */
         inline void addSecondary(G4int trackID, G4int parentID) {
-            trackIDMap_[trackID] = parentID;
+            // Read the depth of the parent first, as getEntry may reallocate the records.
+            const Entry* parent = findEntry(parentID);
+            int depth = parent ? parent->depth + 1 : 0;
+            Entry& entry = getEntry(trackID);
+            entry.parentID = parentID;
+            entry.contained = true;
+            entry.depth = depth;
+        }
+
+        /**
+         * Get the depth of a track in the ancestry, which is 0 for primaries.
+         * @param trackID The track ID.
+         * @return The depth or -1 if the track is not in the map.
+         */
+        int getDepth(G4int trackID) {
+            const Entry* entry = findEntry(trackID);
+            return entry && entry->contained ? entry->depth : -1;
         }
 
         /**
@@ -55,7 +77,7 @@ class TrackMap {
          * the first available Trajectory.
          */
         inline bool hasTrajectory(G4int trackID) {
-            return trajectoryMap_.find(trackID) != trajectoryMap_.end();
+            return getTrajectory(trackID) != nullptr;
         }
 
         /**
@@ -63,7 +85,8 @@ class TrackMap {
          * @param traj The Trajectory to add.
          */
         inline void addTrajectory(Trajectory* traj) {
-            trajectoryMap_[traj->GetTrackID()] = traj;
+            getEntry(traj->GetTrackID()).trajectory = traj;
+            nextVersion();
         }
 
         /**
@@ -71,7 +94,8 @@ class TrackMap {
          * @return True if the track ID is in the map.
          */
         bool contains(G4int trackID) {
-            return trackIDMap_.find(trackID) != trackIDMap_.end();
+            const Entry* entry = findEntry(trackID);
+            return entry && entry->contained;
         }
 
         /**
@@ -81,51 +105,143 @@ class TrackMap {
          * track ID is not assigned to a Trajectory.
          */
         inline Trajectory* getTrajectory(G4int trackID) {
-            if (hasTrajectory(trackID)) {
-                return trajectoryMap_[trackID];
-            } else {
-                return nullptr;
-            }
+            const Entry* entry = findEntry(trackID);
+            return entry ? entry->trajectory : nullptr;
         }
 
         /**
          * Find a trajectory by its track ID.
          * If this track ID does not have a trajectory, then the
          * first trajectory found in its parentage is returned.
-         * @param anEvent The Geant4 event.
          * @param trackkID The track ID of the trajectory to find.
          */
         G4VTrajectory* findTrajectory(G4int trackID) {
-                G4int currTrackID = trackID;
-                G4VTrajectory* traj = nullptr;
-                for (;;) {
-                    traj = trajectoryMap_[currTrackID];
-                    if (traj) {
-                        break;
-                    } else {
-                        if (trackIDMap_.find(currTrackID) != trackIDMap_.end()) {
-                            currTrackID = trackIDMap_[currTrackID];
-                        } else {
-                            break;
-                        }
-                    }
+            Trajectory* traj = nullptr;
+            G4int currTrackID = trackID;
+            for (;;) {
+                Entry* entry = findEntry(currTrackID);
+                if (!entry) {
+                    break;
+                }
+                if (entry->trajectory) {
+                    traj = entry->trajectory;
+                    break;
+                }
+                if (entry->ancestorVersion == version_) {
+                    traj = entry->ancestor;
+                    break;
                 }
-                return traj;
+                if (!entry->contained) {
+                    break;
+                }
+                path_.push_back(entry);
+                currTrackID = entry->parentID;
+            }
+
+            // Remember the result for every track on the path.
+            for (auto entry : path_) {
+                entry->ancestor = traj;
+                entry->ancestorVersion = version_;
             }
+            path_.clear();
 
+            return traj;
+        }
+
+        /**
+         * Clear the map, which only starts a new generation of its records.
+         */
         void clear() {
-            trackIDMap_.clear();
-            trajectoryMap_.clear();
+            ++generation_;
+            nextVersion();
+            if (!generation_) {
+                // The generation wrapped around so the records must actually be cleared.
+                entries_.assign(entries_.size(), Entry());
+                generation_ = 1;
+            }
         }
 
+    private:
+
+        /**
+         * The record of a track.
+         */
+        struct Entry {
+
+                /** Generation of the map the record belongs to. */
+                unsigned generation{0};
+
+                /** True if the parent of the track was added. */
+                bool contained{false};
+
+                /** The parent track ID. */
+                G4int parentID{0};
+
+                /** The depth of the track in the ancestry. */
+                int depth{0};
+
+                /** The trajectory of the track. */
+                Trajectory* trajectory{nullptr};
+
+                /** The nearest trajectory in the parentage, which is valid for one version of the map. */
+                Trajectory* ancestor{nullptr};
+                unsigned ancestorVersion{0};
+        };
+
+        /**
+         * Get the record of a track for modification, creating it if necessary.
+         */
+        Entry& getEntry(G4int trackID) {
+            if (trackID < 0) {
+                G4Exception("TrackMap::getEntry", "", FatalException, "Negative track ID.");
+            }
+            if ((size_t) trackID >= entries_.size()) {
+                entries_.resize(std::max((size_t) trackID + 1, 2 * entries_.size()));
+            }
+            Entry& entry = entries_[trackID];
+            if (entry.generation != generation_) {
+                entry = Entry();
+                entry.generation = generation_;
+            }
+            return entry;
+        }
+
+        /**
+         * Invalidate the remembered ancestors.
+         */
+        void nextVersion() {
+            if (!++version_) {
+                for (auto& entry : entries_) {
+                    entry.ancestorVersion = 0;
+                }
+                version_ = 1;
+            }
+        }
+
+        /**
+         * Find the record of a track.
+         * @return The record or null if the track is not in the map.
+         */
+        Entry* findEntry(G4int trackID) {
+            if (trackID < 0 || (size_t) trackID >= entries_.size() || entries_[trackID].generation != generation_) {
+                return nullptr;
+            }
+            return &entries_[trackID];
+        }
 
     private:
 
-        /** Map of track IDs to parent IDs. */
-        TrackIDMap trackIDMap_;
+        /** Records of the tracks indexed by track ID. */
+        std::vector<Entry> entries_;
+
+        /** The current generation of the records. */
+        unsigned generation_{1};
+
+        /** Version of the map which is incremented when a trajectory is added. */
+        unsigned version_{1};
 
-        /** Map of track IDs to Trajectory objects. */
-        Trajectory::TrajectoryMap trajectoryMap_;
+        /** Records visited by findTrajectory. */
+        std::vector<Entry*> path_;
 };
 
 }
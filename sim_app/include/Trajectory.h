@@ -12,17 +12,21 @@
  */
 #include "G4TrajectoryContainer.hh"
 #include "G4VTrajectory.hh"
-#include "G4Allocator.hh"
 #include "G4Track.hh"
 
+/*
+ * HPS
+ */
+#include "EventArena.h"
+#include "TrajectoryPoint.h"
+#include "TrajectoryPointPolicy.h"
+
 /*
  * C++
  */
 #include <vector>
 #include <cmath>
 
-typedef std::vector<G4VTrajectoryPoint*> TrajectoryPointContainer;
-
 namespace hpssim {
 
 /**
@@ -32,6 +36,12 @@ namespace hpssim {
  * @note
  * Class is based on this Geant4 tip:
  * <a href="http://geant4.slac.stanford.edu/Tips/event/3.html">Trajectory Event Tip</a>
+ *
+ * @note
+ * Trajectories are allocated from the EventArena.  The vertex and end point are
+ * always stored, and the TrajectoryPointPolicy decides which step points in between
+ * are stored.  Points are kept by value, so a trajectory with only its end points
+ * has a fixed size regardless of the number of steps.
  */
 class Trajectory : public G4VTrajectory {
 
@@ -217,8 +227,40 @@ class Trajectory : public G4VTrajectory {
 
     private:
 
-        /** The list of trajectory points. */
-        TrajectoryPointContainer* trajPoints_;
+        /**
+         * Set the end point, keeping the previous one if it was selected by the point policy.
+         */
+        void setEndPoint(const G4ThreeVector& pos, bool keep) {
+            if (hasEndPoint_ && keepEndPoint_) {
+                trajPoints_.push_back(endPoint_);
+            }
+            endPoint_.setPosition(pos);
+            hasEndPoint_ = true;
+            keepEndPoint_ = keep;
+        }
+
+    private:
+
+        /** The vertex point. */
+        TrajectoryPoint vertexPoint_;
+
+        /** The points between the vertex and the end point. */
+        std::vector<TrajectoryPoint> trajPoints_;
+
+        /** The end point, if the track has been stepped. */
+        TrajectoryPoint endPoint_;
+
+        /** True if the track has an end point. */
+        bool hasEndPoint_{false};
+
+        /** True if the end point should be kept when the track takes another step. */
+        bool keepEndPoint_{false};
+
+        /** The number of steps appended to the trajectory. */
+        int nSteps_{0};
+
+        /** The rule for the points stored in this trajectory. */
+        TrajectoryPointPolicy::Rule* pointRule_;
 
         /** The particle definition. */
         G4ParticleDefinition* particleDef_;
@@ -255,18 +297,14 @@ class Trajectory : public G4VTrajectory {
 };
 
 /**
- * Custom memory allocator.
+ * Allocate trajectories from the event arena.
  */
-extern G4Allocator<Trajectory> TrajectoryAllocator;
-
-inline void* Trajectory::operator new(size_t) {
-    void* aTrajectory;
-    aTrajectory = (void*) TrajectoryAllocator.MallocSingle();
-    return aTrajectory;
+inline void* Trajectory::operator new(size_t s) {
+    return EventArena::getArena()->allocate(s);
 }
 
 inline void Trajectory::operator delete(void* aTrajectory) {
-    TrajectoryAllocator.FreeSingle((Trajectory*) aTrajectory);
+    EventArena::deallocate(aTrajectory);
 }
 
 }
@@ -0,0 +1,54 @@
+/**
+ * @file TrajectoryPoint.h
+ * @brief Class providing a compact trajectory point
+ */
+
+#ifndef HPSSIM_TRAJECTORYPOINT_H_
+#define HPSSIM_TRAJECTORYPOINT_H_
+
+/*
+ * Geant4
+ */
+#include "G4VTrajectoryPoint.hh"
+
+namespace hpssim {
+
+/**
+ * @class TrajectoryPoint
+ * @brief Trajectory point with only a position, which is stored by value in its Trajectory
+ */
+class TrajectoryPoint : public G4VTrajectoryPoint {
+
+    public:
+
+        TrajectoryPoint() {
+        }
+
+        TrajectoryPoint(const G4ThreeVector& position) :
+                position_(position) {
+        }
+
+        virtual ~TrajectoryPoint() {
+        }
+
+        const G4ThreeVector GetPosition() const {
+            return position_;
+        }
+
+        const G4ThreeVector& getPosition() const {
+            return position_;
+        }
+
+        void setPosition(const G4ThreeVector& position) {
+            position_ = position;
+        }
+
+    private:
+
+        /** The position of the point [mm]. */
+        G4ThreeVector position_;
+};
+
+}
+
+#endif
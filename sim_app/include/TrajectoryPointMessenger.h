@@ -0,0 +1,57 @@
+#ifndef HPSSIM_TRAJECTORYPOINTMESSENGER_H_
+#define HPSSIM_TRAJECTORYPOINTMESSENGER_H_
+
+/*
+ * Geant4
+ */
+#include "G4UImessenger.hh"
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+
+namespace hpssim {
+
+/**
+ * @class TrajectoryPointMessenger
+ * @brief Messenger for setting which step points are stored in trajectories
+ */
+class TrajectoryPointMessenger : public G4UImessenger {
+
+    public:
+
+        TrajectoryPointMessenger();
+
+        virtual ~TrajectoryPointMessenger();
+
+        void SetNewValue(G4UIcommand* command, G4String newValues);
+
+    private:
+
+        /**
+         * UI dir for trajectory commands.
+         */
+        G4UIdirectory* trajectoryDir_;
+
+        /**
+         * UI command to set the point mode of the job or a region.
+         */
+        G4UIcommand* pointsCmd_;
+
+        /**
+         * UI command to set the point interval in nth mode.
+         */
+        G4UIcommand* intervalCmd_;
+
+        /**
+         * UI command to add a volume whose points are stored in volumes mode.
+         */
+        G4UIcommand* volumeCmd_;
+
+        /**
+         * UI command to print the point policy.
+         */
+        G4UIcommand* printCmd_;
+};
+
+} // namespace hpssim
+
+#endif
@@ -0,0 +1,199 @@
+/**
+ * @file TrajectoryPointPolicy.h
+ * @brief Class defining which step points are stored in trajectories
+ */
+
+#ifndef HPSSIM_TRAJECTORYPOINTPOLICY_H_
+#define HPSSIM_TRAJECTORYPOINTPOLICY_H_
+
+/*
+ * Geant4
+ */
+#include "G4LogicalVolume.hh"
+#include "G4Region.hh"
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4VPhysicalVolume.hh"
+
+/*
+ * C++
+ */
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+
+namespace hpssim {
+
+/**
+ * @class TrajectoryPointPolicy
+ * @brief Defines which step points are stored in trajectories, for the whole job or by region
+ *
+ * @note
+ * The vertex and end point of a trajectory are always stored, as they are used for the
+ * MCParticles.  The policy only decides which points in between are stored:
+ * <ul>
+ * <li>endpoints - none, so a trajectory has a fixed size (the default in batch mode)</li>
+ * <li>nth - every Nth step point</li>
+ * <li>volumes - the step points in a set of logical volumes</li>
+ * <li>full - every step point, e.g. for visualization (the default in interactive mode)</li>
+ * </ul>
+ * The rule of a trajectory is selected by the region of the volume at the track vertex.
+ * Regions without their own rule use the default rule.
+ */
+class TrajectoryPointPolicy {
+
+    public:
+
+        enum Mode {
+            EndPoints,
+            EveryNth,
+            Volumes,
+            Full
+        };
+
+        /**
+         * The points to store in the trajectories of a region.
+         */
+        class Rule {
+
+            public:
+
+                /**
+                 * Return true if the post step point of a step should be stored.
+                 * @param aStep The step.
+                 * @param nSteps The number of steps of the track including this one.
+                 */
+                bool keepPoint(const G4Step* aStep, int nSteps) {
+                    if (mode == Full) {
+                        return true;
+                    } else if (mode == EveryNth) {
+                        return nSteps % interval == 0;
+                    } else if (mode == Volumes) {
+                        return inVolume(aStep->GetPreStepPoint()->GetPhysicalVolume());
+                    }
+                    return false;
+                }
+
+                Mode mode{EndPoints};
+
+                /** Interval of the stored points in nth mode. */
+                int interval{10};
+
+                /** Names of the logical volumes in volumes mode. */
+                std::set<std::string> volumes;
+
+            private:
+
+                bool inVolume(G4VPhysicalVolume* volume) {
+                    if (!volume) {
+                        return false;
+                    }
+                    G4LogicalVolume* logicalVolume = volume->GetLogicalVolume();
+                    auto it = volumeCache_.find(logicalVolume);
+                    if (it == volumeCache_.end()) {
+                        bool found = volumes.count(logicalVolume->GetName());
+                        it = volumeCache_.insert(std::make_pair(logicalVolume, found)).first;
+                    }
+                    return it->second;
+                }
+
+                friend class TrajectoryPointPolicy;
+
+                /** Volumes that were already checked against the names. */
+                std::map<const G4LogicalVolume*, bool> volumeCache_;
+        };
+
+        static TrajectoryPointPolicy* getPolicy() {
+            static TrajectoryPointPolicy thePolicy;
+            return &thePolicy;
+        }
+
+        /**
+         * Get the rule of a region for modification, creating it from the default rule if necessary.
+         * @param region The name of the region or an empty string for the default rule.
+         */
+        Rule& getRule(const std::string& region) {
+            regionRules_.clear();
+            if (region.empty()) {
+                defaultRule_.volumeCache_.clear();
+                return defaultRule_;
+            }
+            auto it = rules_.find(region);
+            if (it == rules_.end()) {
+                it = rules_.insert(std::make_pair(region, defaultRule_)).first;
+            }
+            it->second.volumeCache_.clear();
+            return it->second;
+        }
+
+        /**
+         * Find the rule for the trajectory of a track from the region at its vertex.
+         */
+        Rule* findRule(const G4Track* aTrack) {
+            if (rules_.empty()) {
+                return &defaultRule_;
+            }
+            const G4Region* region = aTrack->GetLogicalVolumeAtVertex()->GetRegion();
+            auto it = regionRules_.find(region);
+            if (it == regionRules_.end()) {
+                Rule* rule = &defaultRule_;
+                if (region) {
+                    auto ruleIt = rules_.find(region->GetName());
+                    if (ruleIt != rules_.end()) {
+                        rule = &ruleIt->second;
+                    }
+                }
+                it = regionRules_.insert(std::make_pair(region, rule)).first;
+            }
+            return it->second;
+        }
+
+        /**
+         * Convert the name of a mode to its value.
+         * @return True if the name is valid.
+         */
+        static bool toMode(const std::string& name, Mode& mode) {
+            if (name == "endpoints") {
+                mode = EndPoints;
+            } else if (name == "nth") {
+                mode = EveryNth;
+            } else if (name == "volumes") {
+                mode = Volumes;
+            } else if (name == "full") {
+                mode = Full;
+            } else {
+                return false;
+            }
+            return true;
+        }
+
+        void print(std::ostream& os) {
+            static const char* modeNames[] = {"endpoints", "nth", "volumes", "full"};
+            os << "TrajectoryPointPolicy: default - " << modeNames[defaultRule_.mode] << std::endl;
+            for (auto& entry : rules_) {
+                os << "TrajectoryPointPolicy: region " << entry.first << " - " << modeNames[entry.second.mode]
+                        << std::endl;
+            }
+        }
+
+    private:
+
+        TrajectoryPointPolicy() {
+        }
+
+    private:
+
+        /** The rule of regions without their own rule. */
+        Rule defaultRule_;
+
+        /** The rules by region name. */
+        std::map<std::string, Rule> rules_;
+
+        /** The rules which were found for each region. */
+        std::map<const G4Region*, Rule*> regionRules_;
+};
+
+}
+
+#endif
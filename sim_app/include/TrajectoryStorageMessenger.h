@@ -0,0 +1,87 @@
+#ifndef HPSSIM_TRAJECTORYSTORAGEMESSENGER_H_
+#define HPSSIM_TRAJECTORYSTORAGEMESSENGER_H_
+
+/*
+ * Geant4
+ */
+#include "G4UImessenger.hh"
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithoutParameter.hh"
+
+namespace hpssim {
+
+class TrajectoryStoragePolicy;
+
+/**
+ * @class TrajectoryStorageMessenger
+ * @brief Messenger for defining the rules of the TrajectoryStoragePolicy
+ *
+ * @note
+ * A rule is started with the add command and its conditions are set
+ * by the commands which follow it.
+ */
+class TrajectoryStorageMessenger : public G4UImessenger {
+
+    public:
+
+        TrajectoryStorageMessenger();
+
+        virtual ~TrajectoryStorageMessenger();
+
+        void SetNewValue(G4UIcommand* command, G4String newValues);
+
+    private:
+
+        /**
+         * UI dir for storage rule commands.
+         */
+        G4UIdirectory* storageDir_;
+
+        /**
+         * UI command to add a rule which stores or drops trajectories.
+         */
+        G4UIcmdWithAString* addCmd_;
+
+        /**
+         * UI command to set the particles of the last rule.
+         */
+        G4UIcmdWithAString* particlesCmd_;
+
+        /**
+         * UI command to set the creator process of the last rule.
+         */
+        G4UIcmdWithAString* processCmd_;
+
+        /**
+         * UI commands to set the kinetic energy range of the last rule.
+         */
+        G4UIcmdWithADoubleAndUnit* minEnergyCmd_;
+        G4UIcmdWithADoubleAndUnit* maxEnergyCmd_;
+
+        /**
+         * UI command to set the region of the last rule.
+         */
+        G4UIcmdWithAString* regionCmd_;
+
+        /**
+         * UI command to set the maximum ancestry depth of the last rule.
+         */
+        G4UIcmdWithAnInteger* maxDepthCmd_;
+
+        /**
+         * UI command to remove all rules.
+         */
+        G4UIcmdWithoutParameter* clearCmd_;
+
+        /**
+         * UI command to print the rules.
+         */
+        G4UIcmdWithoutParameter* printCmd_;
+};
+
+} // namespace hpssim
+
+#endif
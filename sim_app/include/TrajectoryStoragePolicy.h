@@ -0,0 +1,244 @@
+/**
+ * @file TrajectoryStoragePolicy.h
+ * @brief Class defining rules for which tracks have their trajectories stored
+ */
+
+#ifndef HPSSIM_TRAJECTORYSTORAGEPOLICY_H_
+#define HPSSIM_TRAJECTORYSTORAGEPOLICY_H_
+
+/*
+ * HPS
+ */
+#include "ParticleRuleTable.h"
+
+/*
+ * Geant4
+ */
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
+#include "G4Track.hh"
+#include "G4VProcess.hh"
+
+/*
+ * C++
+ */
+#include <cfloat>
+#include <iostream>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace hpssim {
+
+/**
+ * @class TrajectoryStoragePolicy
+ * @brief Rules from macro commands for which secondary tracks have their trajectories stored
+ *
+ * @note
+ * A rule matches a track by its particle species, creator process, kinetic energy at
+ * the vertex, region at the vertex and depth in the ancestry (1 for daughters of primaries).
+ * Conditions which are not set match any track.  The first matching rule decides whether
+ * the trajectory is stored or dropped.  If no rule matches, the region settings from the
+ * detector description decide as before.  Primaries are always stored, and plugins may
+ * still change the save flags of tracks afterwards.
+ *
+ * @par
+ * The rules are compiled at the start of each run into a table of the candidate rules
+ * for each particle species, and regions and particles are resolved from their names,
+ * so deciding for a track only checks the rules which can apply to its species.
+ */
+class TrajectoryStoragePolicy {
+
+    public:
+
+        enum Decision {
+            Default,
+            Store,
+            Drop
+        };
+
+        /**
+         * A storage rule.
+         */
+        struct Rule {
+
+                /** True to store the trajectory of matching tracks or false to drop it. */
+                bool store{true};
+
+                /** Names or PDG codes of the particles (empty for any). */
+                std::vector<std::string> particles;
+
+                /** Name of the creator process (empty for any). */
+                std::string process;
+
+                /** Kinetic energy range at the vertex [MeV]. */
+                double minEnergy{0.};
+                double maxEnergy{DBL_MAX};
+
+                /** Name of the region at the vertex (empty for any). */
+                std::string region;
+
+                /** Maximum depth in the ancestry (negative for any). */
+                int maxDepth{-1};
+        };
+
+        static TrajectoryStoragePolicy* getPolicy() {
+            static TrajectoryStoragePolicy thePolicy;
+            return &thePolicy;
+        }
+
+        /**
+         * Add a rule after the existing ones.
+         * @return The rule for setting its conditions.
+         */
+        Rule& addRule(bool store) {
+            rules_.push_back(Rule());
+            rules_.back().store = store;
+            compiled_.clear();
+            table_.clear();
+            return rules_.back();
+        }
+
+        /**
+         * Get the last rule for setting its conditions.
+         * @return The last rule or null if there are no rules.
+         */
+        Rule* getLastRule() {
+            compiled_.clear();
+            table_.clear();
+            return rules_.size() ? &rules_.back() : nullptr;
+        }
+
+        void clear() {
+            rules_.clear();
+            compiled_.clear();
+            table_.clear();
+        }
+
+        /**
+         * Compile the rules into the table of candidate rules by particle species.
+         * This must be called after the geometry and physics are initialized.
+         */
+        void compile() {
+            compiled_.clear();
+            table_.clear();
+            compiled_.reserve(rules_.size());
+            for (auto& rule : rules_) {
+                compiled_.push_back(CompiledRule());
+                CompiledRule& compiledRule = compiled_.back();
+                compiledRule.rule = &rule;
+                if (rule.region.size()) {
+                    compiledRule.region = G4RegionStore::GetInstance()->GetRegion(rule.region, false);
+                    if (!compiledRule.region) {
+                        G4Exception("TrajectoryStoragePolicy::compile", "", JustWarning,
+                                G4String("The region '" + rule.region + "' does not exist so its rule is ignored."));
+                        compiledRule.valid = false;
+                    }
+                }
+                std::vector<int> pdgCodes = ParticleNames::getPDGCodes(rule.particles, "TrajectoryStoragePolicy::compile");
+                if (compiledRule.valid) {
+                    table_.add(&compiledRule, pdgCodes);
+                }
+            }
+        }
+
+        /**
+         * Decide whether the trajectory of a secondary track is stored.
+         * @param aTrack The track.
+         * @param depth The depth of the track in the ancestry.
+         */
+        Decision decide(const G4Track* aTrack, int depth) {
+            if (rules_.empty()) {
+                return Default;
+            }
+            if (compiled_.size() != rules_.size()) {
+                compile();
+            }
+            for (auto compiledRule : table_.getCandidates(aTrack->GetDefinition()->GetPDGEncoding())) {
+                if (matches(*compiledRule, aTrack, depth)) {
+                    return compiledRule->rule->store ? Store : Drop;
+                }
+            }
+            return Default;
+        }
+
+        void print(std::ostream& os) {
+            os << "TrajectoryStoragePolicy: " << rules_.size() << " rules" << std::endl;
+            for (auto& rule : rules_) {
+                os << "  " << (rule.store ? "store" : "drop") << " particles:";
+                for (auto& particle : rule.particles) {
+                    os << " " << particle;
+                }
+                if (rule.particles.empty()) {
+                    os << " any";
+                }
+                os << ", process: " << (rule.process.size() ? rule.process : "any") << ", energy: ["
+                        << rule.minEnergy << ", " << rule.maxEnergy << "] MeV, region: "
+                        << (rule.region.size() ? rule.region : "any") << ", max depth: ";
+                if (rule.maxDepth >= 0) {
+                    os << rule.maxDepth << std::endl;
+                } else {
+                    os << "any" << std::endl;
+                }
+            }
+        }
+
+    private:
+
+        /**
+         * A rule with its region and particles resolved.
+         */
+        struct CompiledRule {
+                Rule* rule{nullptr};
+                bool valid{true};
+                const G4Region* region{nullptr};
+
+                /** Whether each creator process seen so far matches the rule. */
+                std::unordered_map<const G4VProcess*, bool> processes;
+        };
+
+        TrajectoryStoragePolicy() {
+        }
+
+        static bool matches(CompiledRule& compiledRule, const G4Track* aTrack, int depth) {
+            const Rule& rule = *compiledRule.rule;
+            double energy = aTrack->GetKineticEnergy();
+            if (energy < rule.minEnergy || energy > rule.maxEnergy) {
+                return false;
+            }
+            if (rule.maxDepth >= 0 && depth > rule.maxDepth) {
+                return false;
+            }
+            if (compiledRule.region && aTrack->GetLogicalVolumeAtVertex()->GetRegion() != compiledRule.region) {
+                return false;
+            }
+            if (rule.process.size()) {
+                const G4VProcess* process = aTrack->GetCreatorProcess();
+                auto it = compiledRule.processes.find(process);
+                if (it == compiledRule.processes.end()) {
+                    bool found = process && process->GetProcessName() == rule.process;
+                    it = compiledRule.processes.insert(std::make_pair(process, found)).first;
+                }
+                if (!it->second) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+    private:
+
+        /** The rules in the order they were added. */
+        std::vector<Rule> rules_;
+
+        /** The compiled rules in the same order. */
+        std::vector<CompiledRule> compiled_;
+
+        /** Candidate rules by particle species. */
+        ParticleRuleTable<CompiledRule> table_;
+};
+
+}
+
+#endif
@@ -5,6 +5,16 @@
 
 namespace hpssim {
 
+/**
+ * @class UserStackingAction
+ * @brief Stacking action which forwards to the plugins and stages the event for staging plugins
+ *
+ * @note
+ * When staging plugins are registered, only the new tracks which one of them puts in the
+ * first stage are simulated right away and all others are postponed to the waiting stack.
+ * When the first stage is finished, the staging plugins decide whether to keep the event,
+ * and rejected events are aborted before any postponed track is simulated.
+ */
 class UserStackingAction : public G4UserStackingAction {
 
     public:
@@ -14,6 +24,11 @@ class UserStackingAction : public G4UserStackingAction {
         void NewStage();
 
         void PrepareNewEvent();
+
+    private:
+
+        /** The current stage of the event. */
+        int stage_{0};
 };
 
 
@@ -11,11 +11,14 @@
 
 #include "lcdd/core/VUserTrackInformation.hh"
 
+#include "EventArena.h"
+
 namespace hpssim {
 
 /**
  * @class UserTrackInformation
- * @note Provides extra information associated to a Geant4 track
+ * @note Provides extra information associated to a Geant4 track.
+ * Objects are allocated from the EventArena.
  */
 class UserTrackInformation : public VUserTrackInformation {
 
@@ -27,6 +30,14 @@ class UserTrackInformation : public VUserTrackInformation {
         virtual ~UserTrackInformation() {
         }
 
+        inline void* operator new(size_t s) {
+            return EventArena::getArena()->allocate(s);
+        }
+
+        inline void operator delete(void* obj) {
+            EventArena::deallocate(obj);
+        }
+
         static UserTrackInformation* getUserTrackInformation(const G4Track* aTrack) {
             return static_cast<UserTrackInformation*>(aTrack->GetUserInformation());
         }
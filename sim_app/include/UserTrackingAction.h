@@ -19,8 +19,10 @@
  */
 #include "PluginManager.h"
 #include "TrackMap.h"
+#include "TrajectoryStoragePolicy.h"
 #include "UserPrimaryParticleInformation.h"
 #include "UserTrackInformation.h"
+#include "VolumeTags.h"
 
 namespace hpssim {
 
@@ -118,8 +120,8 @@ class UserTrackingAction : public G4UserTrackingAction {
         void processTrack(const G4Track* aTrack) {
 
             // Setup the track info object.
-            UserTrackInformation* info = nullptr;
-            if (!aTrack->GetUserInformation()) {
+            UserTrackInformation* info = dynamic_cast<UserTrackInformation*>(aTrack->GetUserInformation());
+            if (!info) {
                 info = new UserTrackInformation;
                 info->setInitialMomentum(aTrack->GetMomentum());
                 const_cast<G4Track*>(aTrack)->SetUserInformation(info);
@@ -130,9 +132,13 @@ class UserTrackingAction : public G4UserTrackingAction {
              * (e.g. "tracking region") and particle energy is above threshold or the particle is a primary.
              */
             UserRegionInformation* regionInfo =
-                    (UserRegionInformation*) aTrack->GetLogicalVolumeAtVertex()->GetRegion()->GetUserInformation();
+                    VolumeTags::getVolumeTags()->getRegionInformation(aTrack->GetLogicalVolumeAtVertex());
             bool isPrimary = (aTrack->GetDynamicParticle()->GetPrimaryParticle() != nullptr);
             // TODO: Make sure GPS primary particles pass this check. ^^^
+
+            // Save the association between track ID and its parent ID for all tracks in the event.
+            trackMap_.addSecondary(aTrack->GetTrackID(), aTrack->GetParentID());
+
             bool aboveEnergyThreshold = false;
             bool storeSecondaries = false;
             if (regionInfo) {
@@ -145,7 +151,15 @@ class UserTrackingAction : public G4UserTrackingAction {
             //    std::cout << "UserTrackingAction: Track " << aTrack->GetTrackID() << " is a primary." << std::endl;
             //}
 
-            if ((storeSecondaries && aboveEnergyThreshold) || isPrimary) {
+            // Storage rules from macro commands override the region settings for secondaries.
+            TrajectoryStoragePolicy::Decision decision = TrajectoryStoragePolicy::Default;
+            if (!isPrimary) {
+                decision = TrajectoryStoragePolicy::getPolicy()->decide(aTrack, trackMap_.getDepth(aTrack->GetTrackID()));
+            }
+            bool store = decision == TrajectoryStoragePolicy::Default ?
+                    (storeSecondaries && aboveEnergyThreshold) || isPrimary : decision == TrajectoryStoragePolicy::Store;
+
+            if (store) {
                 /*
                 if (regionInfo && regionInfo->getStoreSecondaries()) {
                     std::cout << "UserTrackingAction: Storing trajectory for " << aTrack->GetTrackID() << " in region "
@@ -168,9 +182,6 @@ class UserTrackingAction : public G4UserTrackingAction {
 
                 info->setSaveFlag(false);
             }
-
-            // Save the association between track ID and its parent ID for all tracks in the event.
-            trackMap_.addSecondary(aTrack->GetTrackID(), aTrack->GetParentID());
         }
 
         TrackMap* getTrackMap() {
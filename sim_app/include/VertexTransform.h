@@ -8,10 +8,15 @@
 #include "G4Event.hh"
 
 #include <iostream>
+#include <cmath>
 #include <cstdlib>
+#include <sstream>
+#include <vector>
 
 namespace hpssim {
 
+class FusedVertexTransform;
+
 /**
  * @class VertexTransform
  * @brief Interface for transforming a generated Geant4
@@ -24,6 +29,384 @@ class VertexTransform {
         virtual ~VertexTransform() {}
 
         virtual void transform(G4Event*) = 0;
+
+        /**
+         * Add this transform to a FusedVertexTransform.
+         * @return False if the transform cannot be fused, in which case the
+         * transforms are applied one at a time.
+         */
+        virtual bool fuse(FusedVertexTransform*) {
+            return false;
+        }
+
+        /**
+         * Draw the random shift which is applied to every vertex in an event.
+         */
+        virtual G4ThreeVector sampleEventShift() {
+            return G4ThreeVector();
+        }
+
+        /**
+         * Draw the random shift which is applied to a single vertex.
+         */
+        virtual G4ThreeVector sampleVertexShift() {
+            return G4ThreeVector();
+        }
+};
+
+/**
+ * @class FusedVertexTransform
+ * @brief A list of transforms compiled into one affine map of the vertex positions,
+ * one rotation of the momenta and a list of random vertex shifts.
+ *
+ * @note
+ * The linear maps and translations of the deterministic transforms are folded into a single
+ * matrix and offset.  Random shifts are drawn from their source transforms in the same order
+ * as the unfused transforms and are carried through the linear maps of the transforms after them,
+ * so the event is transformed in one pass over its vertices and primaries.
+ */
+class FusedVertexTransform : public VertexTransform {
+
+    public:
+
+        /**
+         * Compile a list of transforms, which must stay valid while this object is used.
+         */
+        void compile(const std::vector<VertexTransform*>& transforms) {
+            clear();
+            transforms_ = transforms;
+            for (auto transform : transforms_) {
+                if (!transform->fuse(this)) {
+                    fused_ = false;
+                    break;
+                }
+            }
+            cosTheta_ = std::cos(theta_);
+            sinTheta_ = std::sin(theta_);
+            compiled_ = true;
+        }
+
+        /**
+         * Reset to the identity transform and flag that compilation is needed.
+         */
+        void clear() {
+            transforms_.clear();
+            shifts_.clear();
+            linear_ = Matrix::identity();
+            translation_ = G4ThreeVector();
+            theta_ = 0.;
+            mapPosition_ = false;
+            rotateMomentum_ = false;
+            fused_ = true;
+            compiled_ = false;
+        }
+
+        bool isCompiled() {
+            return compiled_;
+        }
+
+        /**
+         * Return true if all the transforms could be fused.
+         */
+        bool isFused() {
+            return fused_;
+        }
+
+        void transform(G4Event* anEvent) {
+            if (!compiled_ || !fused_) {
+                for (auto transform : transforms_) {
+                    transform->transform(anEvent);
+                }
+                return;
+            }
+            apply(anEvent, true);
+        }
+
+        /**
+         * Apply only the random shifts, for events which had the deterministic
+         * part of the transform applied already (e.g. when they were cached).
+         */
+        void transformRandom(G4Event* anEvent) {
+            apply(anEvent, false);
+        }
+
+        /**
+         * Apply the deterministic part of the transform to a position.
+         */
+        G4ThreeVector mapPosition(const G4ThreeVector& pos) const {
+            return linear_ * pos + translation_;
+        }
+
+        /**
+         * Apply the deterministic part of the transform to a momentum.
+         */
+        G4ThreeVector mapMomentum(const G4ThreeVector& p) const {
+            if (!rotateMomentum_) {
+                return p;
+            }
+            return G4ThreeVector(p.x() * cosTheta_ + p.z() * sinTheta_, p.y(), p.z() * cosTheta_ - p.x() * sinTheta_);
+        }
+
+        /**
+         * Return true if the transform has a deterministic part which changes positions or momenta.
+         */
+        bool isDeterministic() const {
+            return mapPosition_ || rotateMomentum_;
+        }
+
+        /**
+         * Get a string which identifies the deterministic part of the transform exactly,
+         * e.g. for keying caches of transformed events.  Empty if there is no deterministic part.
+         */
+        std::string getFingerprint() const {
+            if (!isDeterministic()) {
+                return "";
+            }
+            std::ostringstream os;
+            os << std::hexfloat;
+            if (mapPosition_) {
+                for (int i = 0; i < 3; i++) {
+                    os << linear_.m[i][0] << ' ' << linear_.m[i][1] << ' ' << linear_.m[i][2] << ' '
+                            << translation_[i] << ' ';
+                }
+            }
+            os << getMomentumFingerprint();
+            return os.str();
+        }
+
+        /**
+         * Get a string which identifies the deterministic part of the transform of the momenta,
+         * for caches which store the vertex positions untransformed.  Empty if the momenta are not changed.
+         */
+        std::string getMomentumFingerprint() const {
+            if (!rotateMomentum_) {
+                return "";
+            }
+            std::ostringstream os;
+            os << std::hexfloat << 'r' << theta_;
+            return os.str();
+        }
+
+        /**
+         * Set the vertex position, discarding the current one.
+         */
+        void setPosition(const G4ThreeVector& pos) {
+            Matrix zero;
+            applyLinear(zero, pos);
+        }
+
+        /**
+         * Rotate the vertex positions and the momenta around the Y axis.
+         */
+        void rotateY(double theta) {
+            applyLinear(Matrix::rotationY(theta), G4ThreeVector());
+            theta_ += theta;
+            rotateMomentum_ = true;
+        }
+
+        /**
+         * Scale the vertex Z position.
+         */
+        void scaleZ(double scale) {
+            Matrix m = Matrix::identity();
+            m.m[2][2] = scale;
+            applyLinear(m, G4ThreeVector());
+        }
+
+        /**
+         * Add a random shift that is drawn once per event from the source transform.
+         */
+        void addEventShift(VertexTransform* source) {
+            shifts_.push_back(Shift(source, false));
+        }
+
+        /**
+         * Add a random shift that is drawn for every vertex from the source transform.
+         */
+        void addVertexShift(VertexTransform* source) {
+            shifts_.push_back(Shift(source, true));
+        }
+
+        /**
+         * Print the compiled transform.
+         */
+        std::ostream& print(std::ostream& os) {
+            if (!fused_) {
+                os << "  unfused list of " << transforms_.size() << " transforms" << std::endl;
+                return os;
+            }
+            for (int i = 0; i < 3; i++) {
+                os << "  [ " << linear_.m[i][0] << " " << linear_.m[i][1] << " " << linear_.m[i][2] << " ] + "
+                        << translation_[i] << std::endl;
+            }
+            os << "  momentum rotation: " << theta_ << " rad" << std::endl;
+            os << "  random shifts: " << shifts_.size() << std::endl;
+            return os;
+        }
+
+    private:
+
+        /**
+         * Minimal 3x3 matrix for composing the linear part of the transforms.
+         */
+        struct Matrix {
+
+            double m[3][3] = {{0., 0., 0.}, {0., 0., 0.}, {0., 0., 0.}};
+
+            static Matrix identity() {
+                Matrix i;
+                i.m[0][0] = i.m[1][1] = i.m[2][2] = 1.;
+                return i;
+            }
+
+            /*
+             * Same convention as RotateTransform: x' = x cos + z sin and z' = z cos - x sin.
+             */
+            static Matrix rotationY(double theta) {
+                Matrix r = identity();
+                r.m[0][0] = std::cos(theta);
+                r.m[0][2] = std::sin(theta);
+                r.m[2][0] = -std::sin(theta);
+                r.m[2][2] = std::cos(theta);
+                return r;
+            }
+
+            Matrix operator*(const Matrix& rhs) const {
+                Matrix result;
+                for (int i = 0; i < 3; i++) {
+                    for (int j = 0; j < 3; j++) {
+                        result.m[i][j] = m[i][0] * rhs.m[0][j] + m[i][1] * rhs.m[1][j] + m[i][2] * rhs.m[2][j];
+                    }
+                }
+                return result;
+            }
+
+            G4ThreeVector operator*(const G4ThreeVector& v) const {
+                return G4ThreeVector(m[0][0] * v.x() + m[0][1] * v.y() + m[0][2] * v.z(),
+                        m[1][0] * v.x() + m[1][1] * v.y() + m[1][2] * v.z(),
+                        m[2][0] * v.x() + m[2][1] * v.y() + m[2][2] * v.z());
+            }
+        };
+
+        /**
+         * A random shift with the linear map of the transforms applied after it.
+         */
+        struct Shift {
+
+            Shift(VertexTransform* theSource, bool isPerVertex) :
+                    source(theSource), perVertex(isPerVertex), linear(Matrix::identity()) {
+            }
+
+            VertexTransform* source;
+            bool perVertex;
+            Matrix linear;
+        };
+
+        /**
+         * Apply a linear map and translation after the current transform.
+         */
+        void applyLinear(const Matrix& m, const G4ThreeVector& t) {
+            linear_ = m * linear_;
+            translation_ = m * translation_ + t;
+            for (auto& shift : shifts_) {
+                shift.linear = m * shift.linear;
+            }
+            mapPosition_ = true;
+        }
+
+        /**
+         * Transform an event in one pass, including the deterministic part if requested.
+         */
+        void apply(G4Event* anEvent, bool deterministic) {
+
+            bool mapPositions = (deterministic && mapPosition_) || !shifts_.empty();
+            bool rotateMomenta = deterministic && rotateMomentum_;
+            if (!mapPositions && !rotateMomenta) {
+                return;
+            }
+
+            // Draw the random shifts in the same order as the unfused transforms would.
+            G4ThreeVector eventShift;
+            bool hasVertexShifts = false;
+            for (auto& shift : shifts_) {
+                if (shift.perVertex) {
+                    if (!hasVertexShifts) {
+                        vertexShifts_.assign(anEvent->GetNumberOfPrimaryVertex(), G4ThreeVector());
+                        hasVertexShifts = true;
+                    }
+                    for (auto& vertexShift : vertexShifts_) {
+                        vertexShift += shift.linear * shift.source->sampleVertexShift();
+                    }
+                } else {
+                    eventShift += shift.linear * shift.source->sampleEventShift();
+                }
+            }
+
+            // Single pass over the vertex list.
+            int iVertex = 0;
+            for (auto vertex = anEvent->GetPrimaryVertex(); vertex; vertex = vertex->GetNext(), iVertex++) {
+                if (mapPositions) {
+                    G4ThreeVector pos = deterministic ? mapPosition(vertex->GetPosition()) : vertex->GetPosition();
+                    pos += eventShift;
+                    if (hasVertexShifts) {
+                        pos += vertexShifts_[iVertex];
+                    }
+                    vertex->SetPosition(pos.x(), pos.y(), pos.z());
+                }
+                if (rotateMomenta) {
+                    rotatePrimaries(vertex);
+                }
+            }
+        }
+
+        /**
+         * Rotate the momenta of all primaries of a vertex, including daughters.
+         */
+        void rotatePrimaries(G4PrimaryVertex* vertex) {
+            primaryStack_.clear();
+            for (auto primary = vertex->GetPrimary(); primary; primary = primary->GetNext()) {
+                primaryStack_.push_back(primary);
+            }
+            while (!primaryStack_.empty()) {
+                G4PrimaryParticle* primary = primaryStack_.back();
+                primaryStack_.pop_back();
+                G4ThreeVector p = mapMomentum(primary->GetMomentum());
+                primary->SetMomentum(p.x(), p.y(), p.z());
+                for (auto dau = primary->GetDaughter(); dau; dau = dau->GetNext()) {
+                    primaryStack_.push_back(dau);
+                }
+            }
+        }
+
+    private:
+
+        /** The source transforms (not owned). */
+        std::vector<VertexTransform*> transforms_;
+
+        /** The random shifts in the order they are drawn. */
+        std::vector<Shift> shifts_;
+
+        /** Linear part of the position map. */
+        Matrix linear_{Matrix::identity()};
+
+        /** Translation of the position map. */
+        G4ThreeVector translation_;
+
+        /** Total momentum rotation angle around Y. */
+        double theta_{0.};
+        double cosTheta_{1.};
+        double sinTheta_{0.};
+
+        /** Flags for a deterministic position map and momentum rotation. */
+        bool mapPosition_{false};
+        bool rotateMomentum_{false};
+
+        bool fused_{true};
+        bool compiled_{false};
+
+        /** Work buffers reused between events. */
+        std::vector<G4ThreeVector> vertexShifts_;
+        std::vector<G4PrimaryParticle*> primaryStack_;
 };
 
 /**
@@ -49,6 +432,11 @@ class PositionTransform : public VertexTransform {
             }
         }
 
+        bool fuse(FusedVertexTransform* fused) {
+            fused->setPosition(G4ThreeVector(x_, y_, z_));
+            return true;
+        }
+
     private:
 
         double x_;
@@ -80,20 +468,10 @@ class GaussSmearTransform : public VertexTransform {
         }
 
         void transform(G4Event* anEvent) {
-            double shiftX, shiftY, shiftZ;
-            shiftX = shiftY = shiftZ = 0;
-            if (sigmaX_ != 0.) {
-                shiftX = randX_->fire();
-                //std::cout << "shiftX: " << shiftX << std::endl;
-            }
-            if (sigmaY_ != 0.) {
-                shiftY = randY_->fire();
-                //std::cout << "shiftY: " << shiftY << std::endl;
-            }
-            if (sigmaZ_ != 0.) {
-                shiftZ = randZ_->fire();
-                //std::cout << "shiftZ: " << shiftZ << std::endl;
-            }
+            G4ThreeVector shift = sampleEventShift();
+            double shiftX = shift.x();
+            double shiftY = shift.y();
+            double shiftZ = shift.z();
             int nVertex = anEvent->GetNumberOfPrimaryVertex();
             for (int iVertex = 0; iVertex < nVertex; iVertex++) {
                 auto vertex = anEvent->GetPrimaryVertex(iVertex);
@@ -116,6 +494,29 @@ class GaussSmearTransform : public VertexTransform {
             }
         }
 
+        bool fuse(FusedVertexTransform* fused) {
+            fused->addEventShift(this);
+            return true;
+        }
+
+        G4ThreeVector sampleEventShift() {
+            double shiftX, shiftY, shiftZ;
+            shiftX = shiftY = shiftZ = 0;
+            if (sigmaX_ != 0.) {
+                shiftX = randX_->fire();
+                //std::cout << "shiftX: " << shiftX << std::endl;
+            }
+            if (sigmaY_ != 0.) {
+                shiftY = randY_->fire();
+                //std::cout << "shiftY: " << shiftY << std::endl;
+            }
+            if (sigmaZ_ != 0.) {
+                shiftZ = randZ_->fire();
+                //std::cout << "shiftZ: " << shiftZ << std::endl;
+            }
+            return G4ThreeVector(shiftX, shiftY, shiftZ);
+        }
+
     private:
 
         double sigmaX_;
@@ -159,6 +560,11 @@ class RotateTransform : public VertexTransform {
             }
         }
 
+        bool fuse(FusedVertexTransform* fused) {
+            fused->rotateY(theta_);
+            return true;
+        }
+
     private:
 
         void rotatePrimary(G4PrimaryParticle* primary) {
@@ -208,6 +614,20 @@ class FlatSmearTransform : public VertexTransform {
             }
         }
 
+        /*
+         * The value drawn above is centered on the current Z and then added to it,
+         * so the fused form is Z doubled plus a shift centered on zero.
+         */
+        bool fuse(FusedVertexTransform* fused) {
+            fused->scaleZ(2.);
+            fused->addVertexShift(this);
+            return true;
+        }
+
+        G4ThreeVector sampleVertexShift() {
+            return G4ThreeVector(0., 0., CLHEP::RandFlat::shoot(-width_ / 2, width_ / 2));
+        }
+
     private:
 
         /** Width of random distribution (default matches 4 micron target thickness). */
@@ -0,0 +1,258 @@
+/**
+ * @file VolumeTags.h
+ * @brief Class providing precomputed tags of the geometry volumes for per-step checks
+ */
+
+#ifndef HPSSIM_VOLUMETAGS_H_
+#define HPSSIM_VOLUMETAGS_H_
+
+/*
+ * Geant4
+ */
+#include "G4LogicalVolume.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4Region.hh"
+#include "G4VPhysicalVolume.hh"
+
+/*
+ * LCDD
+ */
+#include "lcdd/core/UserRegionInformation.hh"
+
+/*
+ * C++
+ */
+#include <cstdint>
+#include <iostream>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace hpssim {
+
+/**
+ * @class VolumeTags
+ * @brief Table of tags for every physical and logical volume, indexed by their instance IDs
+ *
+ * @note
+ * Tags are named bits which are assigned to volumes whose names match regular expressions,
+ * e.g. the target or the modules of an SVT layer.  Plugins get the bits of their tags in
+ * initialize() and test them in the stepping loop with a single array lookup instead of
+ * comparing volume names.  The tracking tag is set on the logical volumes of regions which
+ * store secondaries, and the region information of each logical volume is also cached.
+ *
+ * @par
+ * The table is built after the geometry is constructed, at the start of the run, and it is
+ * rebuilt if tags are added or the number of volumes changes.
+ */
+class VolumeTags {
+
+    public:
+
+        typedef uint64_t Mask;
+
+        /** Tag of the logical volumes in regions which store secondaries. */
+        static const Mask TRACKING = 1;
+
+        static VolumeTags* getVolumeTags() {
+            static VolumeTags theInstance;
+            return &theInstance;
+        }
+
+        /**
+         * Define a tag or add a pattern to an existing one.  Defining the same pattern
+         * for a tag again, e.g. when a plugin is initialized for every run, does nothing.
+         * @param name The name of the tag.
+         * @param pattern Regular expression which is searched for in the volume names.
+         * @return The bit of the tag.
+         */
+        Mask defineTag(const std::string& name, const std::string& pattern) {
+            Mask bit = findTag(name);
+            if (bit) {
+                for (auto& existing : patterns_) {
+                    if (existing.bit == bit && existing.expression == pattern) {
+                        return bit;
+                    }
+                }
+            } else {
+                if (tagNames_.size() == 8 * sizeof(Mask)) {
+                    G4Exception("VolumeTags::defineTag", "", FatalException, "Too many volume tags.");
+                }
+                bit = Mask(1) << tagNames_.size();
+                tagNames_.push_back(name);
+            }
+            patterns_.push_back(Pattern{bit, std::regex(pattern), pattern});
+            built_ = false;
+            return bit;
+        }
+
+        /**
+         * Find the bit of a tag.
+         * @return The bit or 0 if the tag is not defined.
+         */
+        Mask findTag(const std::string& name) const {
+            for (size_t i = 0; i < tagNames_.size(); i++) {
+                if (tagNames_[i] == name) {
+                    return Mask(1) << i;
+                }
+            }
+            return 0;
+        }
+
+        /**
+         * Build the table of tags if it is out of date.
+         */
+        void build() {
+            auto physicalVolumes = G4PhysicalVolumeStore::GetInstance();
+            auto logicalVolumes = G4LogicalVolumeStore::GetInstance();
+            if (built_ && physicalVolumes->size() == nPhysicalVolumes_ && logicalVolumes->size() == nLogicalVolumes_) {
+                return;
+            }
+
+            logicalTags_.clear();
+            regionInfo_.clear();
+            for (auto volume : *logicalVolumes) {
+                size_t id = volume->GetInstanceID();
+                if (id >= logicalTags_.size()) {
+                    logicalTags_.resize(id + 1, 0);
+                    regionInfo_.resize(id + 1, nullptr);
+                }
+                Mask tags = match(volume->GetName());
+                G4Region* region = volume->GetRegion();
+                if (region) {
+                    auto info = (UserRegionInformation*) region->GetUserInformation();
+                    regionInfo_[id] = info;
+                    if (info && info->getStoreSecondaries()) {
+                        tags |= TRACKING;
+                    }
+                }
+                logicalTags_[id] = tags;
+            }
+
+            physicalTags_.clear();
+            for (auto volume : *physicalVolumes) {
+                size_t id = volume->GetInstanceID();
+                if (id >= physicalTags_.size()) {
+                    physicalTags_.resize(id + 1, 0);
+                }
+                physicalTags_[id] = match(volume->GetName());
+            }
+
+            nPhysicalVolumes_ = physicalVolumes->size();
+            nLogicalVolumes_ = logicalVolumes->size();
+            built_ = true;
+        }
+
+        /**
+         * Get the tags of a physical volume matched by its own name.
+         */
+        Mask getTags(const G4VPhysicalVolume* volume) const {
+            size_t id = volume ? volume->GetInstanceID() : physicalTags_.size();
+            return id < physicalTags_.size() ? physicalTags_[id] : 0;
+        }
+
+        /**
+         * Get the tags of a logical volume matched by its own name, plus the tracking tag.
+         */
+        Mask getTags(const G4LogicalVolume* volume) const {
+            size_t id = volume ? volume->GetInstanceID() : logicalTags_.size();
+            return id < logicalTags_.size() ? logicalTags_[id] : 0;
+        }
+
+        /**
+         * Return true if a physical volume has any of the tags in a mask.
+         */
+        bool hasTag(const G4VPhysicalVolume* volume, Mask mask) const {
+            return getTags(volume) & mask;
+        }
+
+        /**
+         * Return true if a logical volume has any of the tags in a mask.
+         */
+        bool hasTag(const G4LogicalVolume* volume, Mask mask) const {
+            return getTags(volume) & mask;
+        }
+
+        /**
+         * Get the cached region information of a logical volume.
+         */
+        UserRegionInformation* getRegionInformation(const G4LogicalVolume* volume) const {
+            size_t id = volume->GetInstanceID();
+            if (id < regionInfo_.size()) {
+                return regionInfo_[id];
+            }
+            // Volume created after the table was built.
+            return (UserRegionInformation*) volume->GetRegion()->GetUserInformation();
+        }
+
+        void print(std::ostream& os) const {
+            os << "VolumeTags: " << tagNames_.size() << " tags" << std::endl;
+            for (auto& pattern : patterns_) {
+                for (size_t i = 0; i < tagNames_.size(); i++) {
+                    if (pattern.bit == Mask(1) << i) {
+                        os << "  " << tagNames_[i] << " - '" << pattern.expression << "'" << std::endl;
+                    }
+                }
+            }
+            if (built_) {
+                for (auto volume : *G4PhysicalVolumeStore::GetInstance()) {
+                    Mask tags = getTags(volume) | getTags(volume->GetLogicalVolume());
+                    if (tags) {
+                        os << "  " << volume->GetName() << ":";
+                        for (size_t i = 0; i < tagNames_.size(); i++) {
+                            if (tags & (Mask(1) << i)) {
+                                os << " " << tagNames_[i];
+                            }
+                        }
+                        os << std::endl;
+                    }
+                }
+            }
+        }
+
+    private:
+
+        struct Pattern {
+                Mask bit;
+                std::regex regex;
+                std::string expression;
+        };
+
+        VolumeTags() {
+            tagNames_.push_back("tracking");
+        }
+
+        Mask match(const std::string& name) const {
+            Mask tags = 0;
+            for (auto& pattern : patterns_) {
+                if (std::regex_search(name, pattern.regex)) {
+                    tags |= pattern.bit;
+                }
+            }
+            return tags;
+        }
+
+    private:
+
+        /** Names of the tags by bit index. */
+        std::vector<std::string> tagNames_;
+
+        /** Patterns of the volume names for each tag. */
+        std::vector<Pattern> patterns_;
+
+        /** Tags of the physical and logical volumes by instance ID. */
+        std::vector<Mask> physicalTags_;
+        std::vector<Mask> logicalTags_;
+
+        /** Region information of the logical volumes by instance ID. */
+        std::vector<UserRegionInformation*> regionInfo_;
+
+        bool built_{false};
+        size_t nPhysicalVolumes_{0};
+        size_t nLogicalVolumes_{0};
+};
+
+}
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef HPSSIM_VOLUMETAGSMESSENGER_H_
+#define HPSSIM_VOLUMETAGSMESSENGER_H_
+
+/*
+ * Geant4
+ */
+#include "G4UImessenger.hh"
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIcmdWithoutParameter.hh"
+
+namespace hpssim {
+
+/**
+ * @class VolumeTagsMessenger
+ * @brief Messenger for defining the tags of the geometry volumes
+ */
+class VolumeTagsMessenger : public G4UImessenger {
+
+    public:
+
+        VolumeTagsMessenger();
+
+        virtual ~VolumeTagsMessenger();
+
+        void SetNewValue(G4UIcommand* command, G4String newValues);
+
+    private:
+
+        /**
+         * UI dir for volume commands.
+         */
+        G4UIdirectory* volumesDir_;
+
+        /**
+         * UI command to tag the volumes matching a pattern.
+         */
+        G4UIcommand* tagCmd_;
+
+        /**
+         * UI command to print the tags.
+         */
+        G4UIcmdWithoutParameter* printCmd_;
+};
+
+} // namespace hpssim
+
+#endif
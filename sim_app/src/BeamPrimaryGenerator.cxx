@@ -6,6 +6,10 @@ BeamPrimaryGenerator::BeamPrimaryGenerator(std::string name) :
         PrimaryGenerator(name) {
 }
 
+BeamPrimaryGenerator::~BeamPrimaryGenerator() {
+    delete electron_;
+}
+
 void BeamPrimaryGenerator::GeneratePrimaryVertex(G4Event* anEvent) {
     if (verbose_ > 1) {
         std::cout << "BeamPrimaryGenerator: Generating " << nelectrons_ << " electrons in event "
@@ -22,27 +26,52 @@ void BeamPrimaryGenerator::GeneratePrimaryVertex(G4Event* anEvent) {
         }
     }
 
-    for (int i = 0; i < nGenerate; i++) {
+    if (nGenerate <= 0) {
+        return;
+    }
 
-        G4PrimaryVertex* vertex = new G4PrimaryVertex();
-        G4ThreeVector sampledPosition;
-        sampledPosition.setX(position_.x() + CLHEP::RandGauss::shoot(0, sigmaX_));
-        sampledPosition.setY(position_.y() + CLHEP::RandGauss::shoot(0, sigmaY_));
-        sampledPosition.setZ(position_.z());
+    sampleBunch(nGenerate);
+
+    for (int i = 0; i < nGenerate; i++) {
 
         if (verbose_ > 2) {
-            std::cout << "BeamPrimaryGenerator: Sampled pos " << sampledPosition << " for electron " << i << std::endl;
+            std::cout << "BeamPrimaryGenerator: Sampled pos (" << vertexX_[i] << "," << vertexY_[i] << ","
+                    << position_.z() << ") for electron " << i << std::endl;
         }
 
-        vertex->SetPosition(sampledPosition.x(), sampledPosition.y(), sampledPosition.z());
+        G4PrimaryVertex* vertex = new G4PrimaryVertex(vertexX_[i], vertexY_[i], position_.z(), 0.);
         anEvent->AddPrimaryVertex(vertex);
 
-        G4PrimaryParticle* primaryParticle = new G4PrimaryParticle();
-        static auto electronDef = G4ParticleTable::GetParticleTable()->FindParticle("e-");
-        primaryParticle->SetParticleDefinition(electronDef);
-        primaryParticle->SetMomentumDirection(direction_);
-        primaryParticle->SetTotalEnergy(energy_);
-        vertex->SetPrimary(primaryParticle);
+        // The copy has the definition, direction and energy of the template (user info is not copied).
+        vertex->SetPrimary(new G4PrimaryParticle(*electron_));
+    }
+}
+
+void BeamPrimaryGenerator::sampleBunch(int nElectrons) {
+
+    flat_.resize(2 * nElectrons);
+    vertexX_.resize(nElectrons);
+    vertexY_.resize(nElectrons);
+
+    // Get all the uniform numbers for the bunch from the engine in one call.
+    CLHEP::HepRandom::getTheEngine()->flatArray(2 * nElectrons, flat_.data());
+
+    /*
+     * Box-Muller transform giving the X and Y offsets of one electron from a pair of uniform numbers.
+     * The loop has no branches and works on flat arrays so that it can be vectorized.
+     * The engine never returns exactly 0 so the log is always finite.
+     */
+    const double* u1 = flat_.data();
+    const double* u2 = flat_.data() + nElectrons;
+    double* x = vertexX_.data();
+    double* y = vertexY_.data();
+    const double x0 = position_.x();
+    const double y0 = position_.y();
+    for (int i = 0; i < nElectrons; i++) {
+        double r = std::sqrt(-2. * std::log(u1[i]));
+        double phi = CLHEP::twopi * u2[i];
+        x[i] = x0 + sigmaX_ * r * std::cos(phi);
+        y[i] = y0 + sigmaY_ * r * std::sin(phi);
     }
 }
 
@@ -79,8 +108,18 @@ void BeamPrimaryGenerator::initialize() {
         smearNElectrons_ = true;
     }
 
-    // Add transformation into beam coordinates.
-    this->addTransform(new RotateTransform);
+    // Setup the template for the beam electrons.
+    if (!electron_) {
+        electron_ = new G4PrimaryParticle(G4ParticleTable::GetParticleTable()->FindParticle("e-"));
+    }
+    electron_->SetMomentumDirection(direction_);
+    electron_->SetTotalEnergy(energy_);
+
+    // Add transformation into beam coordinates, only once if there are multiple runs.
+    if (!rotateAdded_) {
+        this->addTransform(new RotateTransform);
+        rotateAdded_ = true;
+    }
 }
 
 void BeamPrimaryGenerator::computeNumberOfElectrons() {
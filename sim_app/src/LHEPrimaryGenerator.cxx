@@ -8,38 +8,49 @@
 #include "G4SystemOfUnits.hh"
 #include "G4UnknownParticle.hh"
 
+#include "GeneratorCacheRegistry.h"
 #include "UserPrimaryParticleInformation.h"
 
 namespace hpssim {
 
 LHEPrimaryGenerator::LHEPrimaryGenerator(std::string name, LHEReader* theReader) :
-        PrimaryGenerator(name), reader_(theReader), lheEvent_(nullptr) {
+        PrimaryGenerator(name), reader_(theReader) {
 }
 
 LHEPrimaryGenerator::~LHEPrimaryGenerator() {
     if (reader_) {
         delete reader_;
     }
+    MemoryBudget::getBudget()->release(getIndexName());
 }
 
 void LHEPrimaryGenerator::GeneratePrimaryVertex(G4Event* anEvent) {
 
+    if (!currentCache_) {
+        return;
+    }
+
     auto tbl = G4ParticleTable::GetParticleTable();
 
     G4PrimaryVertex* vertex = new G4PrimaryVertex();
-    vertex->SetPosition(0, 0, 0);
-    vertex->SetWeight(lheEvent_->getXWGTUP());
+    if (isCacheTransformed()) {
+        vertex->SetPosition(vertexPosition_.x(), vertexPosition_.y(), vertexPosition_.z());
+    } else {
+        vertex->SetPosition(0, 0, 0);
+    }
 
-    std::map<LHEParticle*, G4PrimaryParticle*> particleMap;
+    const LHEEventRecord& event = currentCache_->getEvent(currentIndex_);
+    vertex->SetWeight(event.xwgtup);
 
-    int particleIndex = 0;
-    const std::vector<LHEParticle*>& particles = lheEvent_->getParticles();
-    for (std::vector<LHEParticle*>::const_iterator it = particles.begin(); it != particles.end(); it++) {
+    const LHEParticleRecord* particles = currentCache_->getParticles(event);
+    int nParticles = event.nParticles;
+    primaries_.assign(nParticles, nullptr);
+    for (int particleIndex = 0; particleIndex < nParticles; particleIndex++) {
 
-        LHEParticle* particle = (*it);
-        if( verbose_ > 1) particle->print(std::cout);
+        const LHEParticleRecord& particle = particles[particleIndex];
+        if( verbose_ > 1) LHEEventCache::print(particle, std::cout);
 
-        int idup = particle->getIDUP();
+        int idup = particle.idup;
 
         // Change bad generator IDs to valid PDG codes.
         if (idup == 611) {
@@ -68,21 +79,23 @@ void LHEPrimaryGenerator::GeneratePrimaryVertex(G4Event* anEvent) {
                 }
             }
 
-            primary->Set4Momentum(particle->getPUP(0) * GeV, particle->getPUP(1) * GeV, particle->getPUP(2) * GeV,
-                    particle->getPUP(3) * GeV);
-            primary->SetProperTime(particle->getVTIMUP() * nanosecond);
+            primary->Set4Momentum(particle.pup[0] * GeV, particle.pup[1] * GeV, particle.pup[2] * GeV,
+                    particle.pup[3] * GeV);
+            primary->SetProperTime(particle.vtimup * nanosecond);
 
             UserPrimaryParticleInformation* primaryInfo = new UserPrimaryParticleInformation();
-            primaryInfo->setGenStatus(particle->getISTUP());
+            primaryInfo->setGenStatus(particle.istup);
             primary->SetUserInformation(primaryInfo);
 
-            particleMap[particle] = primary;
+            primaries_[particleIndex] = primary;
 
             /*
              * Assign primary as daughter but only if the mother is not a DOC particle.
+             * Mothers are only found if they come before their daughters in the event.
              */
-            if (particle->getMother(0) != NULL && particle->getMother(0)->getISTUP() > 0) {
-                G4PrimaryParticle* primaryMom = particleMap[particle->getMother(0)];
+            int motherIndex = particle.mothup[0] - 1;
+            if (motherIndex >= 0 && motherIndex < nParticles && particles[motherIndex].istup > 0) {
+                G4PrimaryParticle* primaryMom = primaries_[motherIndex];
                 if (primaryMom != NULL) {
                     primaryMom->SetDaughter(primary);
                 }
@@ -96,8 +109,6 @@ void LHEPrimaryGenerator::GeneratePrimaryVertex(G4Event* anEvent) {
         }
 
         if(verbose_ > 1) std::cout << std::endl;
-
-        ++particleIndex;
     }
 
     if(verbose_ > 1) vertex->Print();
@@ -107,7 +118,6 @@ void LHEPrimaryGenerator::GeneratePrimaryVertex(G4Event* anEvent) {
 LHEPrimaryGenerator::LHEPrimaryGenerator(std::string name) :
         PrimaryGenerator(name) {
     reader_ = nullptr;
-    lheEvent_ = nullptr;
 }
 
 bool LHEPrimaryGenerator::isFileBased() {
@@ -119,21 +129,54 @@ bool LHEPrimaryGenerator::supportsRandomAccess() {
 }
 
 int LHEPrimaryGenerator::getNumEvents() {
-    return events_.size();
+    return events_ ? events_->size() : eventOffsets_.size();
 }
 
 void LHEPrimaryGenerator::readNextEvent() throw(EndOfFileException) {
-    lheEvent_ = reader_->readNextEvent();
-    if (!lheEvent_) {
+    eventBuffer_.clear();
+    currentCache_ = nullptr;
+    if (!reader_->readNextEvent(eventBuffer_)) {
         throw EndOfFileException();
     }
+    currentCache_ = &eventBuffer_;
+    currentIndex_ = 0;
 }
 
 void LHEPrimaryGenerator::readEvent(long index, bool removeEvent) throw(NoSuchRecordException) {
     // TODO: check validity of index
-    lheEvent_ = events_[index];
+    if (!events_) {
+        // Parse the indexed event from the file.
+        reader_->seek(eventOffsets_[index]);
+        eventBuffer_.clear();
+        currentCache_ = nullptr;
+        if (!reader_->readNextEvent(eventBuffer_)) {
+            throw NoSuchRecordException(index);
+        }
+        if (isCacheTransformed()) {
+            transformMomenta(eventBuffer_.getParticles(), *getCacheTransform());
+        }
+        currentCache_ = &eventBuffer_;
+        currentIndex_ = 0;
+        if (removeEvent) {
+            eventOffsets_.erase(eventOffsets_.begin() + index);
+            eventWeights_.erase(eventWeights_.begin() + index);
+        }
+        return;
+    }
+    currentCache_ = events_.get();
+    currentIndex_ = index;
     if (removeEvent) {
-        events_.erase(events_.begin() + index);
+        // Keep a copy of the event as its record is removed from the cache.
+        eventBuffer_.clear();
+        eventBuffer_.addEvent(*events_, index);
+        if (!ownEvents_) {
+            // Copy the shared cache before modifying it.
+            ownEvents_ = std::make_shared<LHEEventCache>(*events_);
+            events_ = ownEvents_;
+        }
+        ownEvents_->removeEvent(index);
+        currentCache_ = &eventBuffer_;
+        currentIndex_ = 0;
     }
 }
 
@@ -152,31 +195,166 @@ void LHEPrimaryGenerator::openFile(std::string file) {
     setupEventSampling();
 }
 
+void LHEPrimaryGenerator::reuseFile() {
+
+    // The event sampling may have been changed since the file was opened.
+    setupEventSampling();
+
+    // The cache key does not depend on the position transform, which may also have been changed.
+    updateVertexPosition();
+}
+
+long LHEPrimaryGenerator::getFileEventCount(std::string file) {
+    LHEReader reader(file);
+    long numEvents = reader.getNumEvents();
+    reader.close();
+    return numEvents;
+}
+
 void LHEPrimaryGenerator::cacheEvents() {
 
-    // Clear record cache.
-    if (events_.size()) {
-        for (auto event : events_) {
-            delete event;
+    // Release the cache or index of the previous file.
+    currentCache_ = nullptr;
+    events_.reset();
+    ownEvents_.reset();
+    std::vector<std::streampos>().swap(eventOffsets_);
+    std::vector<double>().swap(eventWeights_);
+    MemoryBudget::getBudget()->release(getIndexName());
+
+    updateVertexPosition();
+    const FusedVertexTransform* transform = getCacheTransform();
+
+    std::string key = getCacheKey();
+    events_ = GeneratorCacheRegistry::getRegistry()->find<LHEEventCache>(key);
+    if (events_) {
+        if (verbose_ > 1) {
+            std::cout << "LHEPrimaryGenerator: Using shared cache with " << events_->size() << " LHE events" << std::endl;
+        }
+        return;
+    }
+
+    // Attach to a cache built by another process or build it for them.
+    auto file = GeneratorCacheRegistry::getRegistry()->openSharedFile(key);
+    if (file && file->isComplete()) {
+        auto cache = std::make_shared<LHEEventCache>();
+        cache->map(file);
+        events_ = cache;
+        GeneratorCacheRegistry::getRegistry()->add(key, events_);
+        if (verbose_ > 1) {
+            std::cout << "LHEPrimaryGenerator: Using shared memory cache with " << events_->size() << " LHE events" << std::endl;
         }
+        return;
     }
 
-    LHEEvent* event = reader_->readNextEvent();
-    while (event != nullptr) {
-        events_.push_back(event);
-        event = reader_->readNextEvent();
+    auto cache = std::make_shared<LHEEventCache>();
+    if (reader_->getNumEvents() > 0) {
+        cache->reserve(reader_->getNumEvents());
     }
 
+    // Keep the positions of the events in case the cache does not fit in the memory budget.
+    std::vector<std::streampos> offsets;
+    MemoryBudget* budget = MemoryBudget::getBudget();
+    while (true) {
+        std::streampos offset = reader_->tell();
+        if (!reader_->readNextEvent(*cache)) {
+            break;
+        }
+        offsets.push_back(offset);
+        if (offsets.size() % 1000 == 0
+                && !budget->fits(key, cache->getMemoryUsage() + offsets.capacity() * sizeof(std::streampos))) {
+            indexEvents(*cache, offsets);
+            return;
+        }
+    }
+
+    // Apply the deterministic transforms to the momenta.
+    if (transform) {
+        transformMomenta(cache->getParticles(), *transform);
+    }
+
+    if (file) {
+        cache = GeneratorCacheRegistry::publish(file, cache);
+    }
+
+    events_ = GeneratorCacheRegistry::account(key, cache, cache->getMemoryUsage());
+    GeneratorCacheRegistry::getRegistry()->add(key, events_);
+
     if (verbose_ > 1) {
-        std::cout << "LHEPrimaryGenerator: Cached " << events_.size() << " LHE events for random access" << std::endl;
+        std::cout << "LHEPrimaryGenerator: Cached " << events_->size() << " LHE events for random access" << std::endl;
+    }
+}
+
+void LHEPrimaryGenerator::indexEvents(const LHEEventCache& cache, std::vector<std::streampos>& offsets) {
+
+    G4Exception("LHEPrimaryGenerator::cacheEvents", "", JustWarning,
+            G4String("Indexing the events of '" + getName() + "' instead of caching them to fit in the memory budget."));
+
+    eventOffsets_.swap(offsets);
+    eventWeights_.reserve(eventOffsets_.capacity());
+    for (long index = 0; index < cache.size(); index++) {
+        eventWeights_.push_back(cache.getEvent(index).xwgtup);
+    }
+
+    // Index the rest of the file, keeping only one event in memory.
+    while (true) {
+        std::streampos offset = reader_->tell();
+        eventBuffer_.clear();
+        if (!reader_->readNextEvent(eventBuffer_)) {
+            break;
+        }
+        eventOffsets_.push_back(offset);
+        eventWeights_.push_back(eventBuffer_.getEvent(0).xwgtup);
+    }
+    eventBuffer_.clear();
+
+    MemoryBudget::getBudget()->setUsage(getIndexName(),
+            eventOffsets_.capacity() * sizeof(std::streampos) + eventWeights_.capacity() * sizeof(double));
+
+    if (verbose_ > 1) {
+        std::cout << "LHEPrimaryGenerator: Indexed " << eventOffsets_.size() << " LHE events for random access" << std::endl;
+    }
+}
+
+void LHEPrimaryGenerator::transformMomenta(std::vector<LHEParticleRecord>& particles, const FusedVertexTransform& transform) {
+    for (auto& particle : particles) {
+        G4ThreeVector p = transform.mapMomentum(G4ThreeVector(particle.pup[0], particle.pup[1], particle.pup[2]));
+        particle.pup[0] = p.x();
+        particle.pup[1] = p.y();
+        particle.pup[2] = p.z();
+    }
+}
+
+std::string LHEPrimaryGenerator::getIndexName() {
+    return "LHE index of '" + getName() + "'";
+}
+
+double LHEPrimaryGenerator::getEventWeight(long index) {
+    return events_ ? events_->getEvent(index).xwgtup : eventWeights_[index];
+}
+
+bool LHEPrimaryGenerator::supportsCacheTransform() {
+    return true;
+}
+
+std::string LHEPrimaryGenerator::getCacheKey() {
+    // The cache only contains the transformed momenta, as the vertex position is mapped separately.
+    const FusedVertexTransform* transform = getCacheTransform();
+    return GeneratorCacheRegistry::makeKey("LHE", getCurrentFile(), transform ? transform->getMomentumFingerprint() : "");
+}
+
+void LHEPrimaryGenerator::updateVertexPosition() {
+    const FusedVertexTransform* transform = getCacheTransform();
+    if (transform) {
+        // LHE events are all generated at the origin.
+        vertexPosition_ = transform->mapPosition(G4ThreeVector(0, 0, 0));
     }
 }
 
 void LHEPrimaryGenerator::deleteEvent() {
-    if (lheEvent_) {
-        if( verbose_ > 1) std::cout << "LHEPrimaryGenerator: Deleting LHE event" << std::endl;
-        delete lheEvent_;
-        lheEvent_ = nullptr;
+    // The event data is owned by the caches so there is nothing to delete here.
+    if (currentCache_) {
+        if( verbose_ > 1) std::cout << "LHEPrimaryGenerator: Releasing LHE event" << std::endl;
+        currentCache_ = nullptr;
     }
 }
 
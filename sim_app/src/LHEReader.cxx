@@ -9,8 +9,32 @@
 
 #include <stdexcept>
 
+#include "globals.hh"
+
 namespace hpssim {
 
+/*
+ * Parse the numbers in a line of an LHE event block without creating tokens.
+ * Returns the number of values that were read, which may be greater than max
+ * if the line has extra values.
+ */
+static int parseValues(const char* line, double* values, int max) {
+    int n = 0;
+    char* end = nullptr;
+    while (true) {
+        double value = strtod(line, &end);
+        if (end == line) {
+            break;
+        }
+        if (n < max) {
+            values[n] = value;
+        }
+        ++n;
+        line = end;
+    }
+    return n;
+}
+
 LHEReader::LHEReader(std::string& filename) {
     std::cout << "LHEReader: Opening LHE file '" << filename << "'" << std::endl;
     ifs_.open(filename.c_str(), std::ifstream::in);
@@ -111,6 +135,72 @@ LHEEvent* LHEReader::readNextEvent() {
     return nextEvent;
 }
 
+bool LHEReader::readNextEvent(LHEEventCache& cache) {
+
+    std::string line;
+    bool foundEventElement = false;
+    while (getline(ifs_, line)) {
+        if (line == "<event>") {
+            foundEventElement = true;
+            break;
+        }
+    }
+
+    if (!foundEventElement) {
+        // This probably just means that all events have been processed.
+        return false;
+    }
+
+    getline(ifs_, line);
+
+    double values[13];
+    if (parseValues(line.c_str(), values, 13) != 6) {
+        std::cerr << "ERROR: Bad event information record in LHE file ..." << std::endl;
+        std::cerr << "  " << line << std::endl;
+        G4Exception("LHEReader::readNextEvent", "LHEEventError", FatalException, "Wrong number of tokens in LHE event information record.");
+    }
+
+    LHEEventRecord& event = cache.addEvent();
+    event.nup = values[0];
+    event.idprup = values[1];
+    event.xwgtup = values[2];
+    event.scalup = values[3];
+    event.aqedup = values[4];
+    event.aqcdup = values[5];
+
+    while (getline(ifs_, line)) {
+
+        if (line == "</event>") {
+            break;
+        }
+
+        if (line[0] == '<') {
+            // Ignore tags embedded in event block by MG5!
+            std::cerr << "LHEReader: Ignoring garbage line \"" << line << "\" in input!" << std::endl;
+        } else {
+            if (parseValues(line.c_str(), values, 13) != 13) {
+                std::cerr << "ERROR: Bad particle record in LHE file ..." << std::endl;
+                std::cerr << "  " << line << std::endl;
+                G4Exception("LHEReader::readNextEvent", "LHEParticleError", FatalException, "Wrong number of tokens in LHE particle record.");
+            }
+            LHEParticleRecord& particle = cache.addParticle();
+            particle.idup = values[0];
+            particle.istup = values[1];
+            particle.mothup[0] = values[2];
+            particle.mothup[1] = values[3];
+            particle.icolup[0] = values[4];
+            particle.icolup[1] = values[5];
+            for (int i = 0; i < 5; i++) {
+                particle.pup[i] = values[6 + i];
+            }
+            particle.vtimup = values[11];
+            particle.spinup = values[12];
+        }
+    }
+
+    return true;
+}
+
 void LHEReader::readNumEvents() {
     std::string line;
     while (getline(ifs_, line)) {
@@ -130,6 +220,15 @@ void LHEReader::readNumEvents() {
     }
 }
 
+std::streampos LHEReader::tell() {
+    return ifs_.tellg();
+}
+
+void LHEReader::seek(std::streampos pos) {
+    ifs_.clear();
+    ifs_.seekg(pos);
+}
+
 double LHEReader::getCrossSection() {
     return crossSection_;
 }
@@ -408,16 +408,8 @@ IMPL::LCCollectionVec* LcioPersistencyManager::writeCalorimeterHitsCollection(G4
                         "Bad track ID in cal hit contribution.");
             }
 
-            // Find the first parent track with a trajectory; it could actually be this track.
-            G4VTrajectory* traj = builder_->getTrackMap().findTrajectory(trackID);
-            if (!traj) {
-                std::cerr << "LcioPersistencyManager: No trajectory found for track ID " << trackID << std::endl;
-                G4Exception("LcioPersistencyManager::writeCalorimeterHitsCollections", "", FatalException,
-                        "No trajectory found for track ID.");
-            }
-
-            // Lookup an MCParticle from the parent, which should exist!
-            auto mcp = builder_->findMCParticle(traj->GetTrackID());
+            // Find the MCParticle of the first parent track with a trajectory; it could actually be this track.
+            auto mcp = builder_->findMCParticle(trackID);
             if (!mcp) {
                 std::cerr << "LcioPersistencyManager: No MCParticle found for track ID " << trackID << std::endl;
                 G4Exception("LcioPersistencyManager::writeCalorimeterHitsCollection", "", FatalException,
@@ -9,34 +9,18 @@ MCParticleBuilder::MCParticleBuilder(TrackMap* trackMap) :
 MCParticleBuilder::~MCParticleBuilder() {
 }
 
-void MCParticleBuilder::buildParticleMap(G4TrajectoryContainer* trajectories, IMPL::LCCollectionVec* collVec) {
-    particleMap_.clear();
-    for (auto trajectory : *trajectories->GetVector()) {
-        if (Trajectory::getTrajectory(trajectory)->getSaveFlag()) {
-            auto particle = new IMPL::MCParticleImpl;
-            collVec->addElement(particle);
-            particleMap_[trajectory->GetTrackID()] = particle;
-        }
-    }
-}
-
 IMPL::MCParticleImpl* MCParticleBuilder::findMCParticle(G4int trackID) {
     G4VTrajectory* traj = trackMap_->findTrajectory(trackID);
     if (traj != nullptr) {
-        return particleMap_[traj->GetTrackID()];
+        return getMCParticle(traj->GetTrackID());
     } else {
         return nullptr;
     }
 }
 
-void MCParticleBuilder::buildMCParticle(Trajectory* traj) {
-
-    IMPL::MCParticleImpl* p = particleMap_[traj->GetTrackID()];
+IMPL::MCParticleImpl* MCParticleBuilder::buildMCParticle(Trajectory* traj) {
 
-    if (!p) {
-        std::cerr << "MCParticleBuilder: MCParticle not found for track ID " << traj->GetTrackID() << std::endl;
-        G4Exception("SimParticleBuilder::buildSimParticle", "", FatalException, "MCParticle not found for Trajectory.");
-    }
+    auto p = new IMPL::MCParticleImpl;
 
     p->setGeneratorStatus(traj->getGenStatus());
     p->setPDG(traj->GetPDGEncoding());
@@ -59,9 +43,15 @@ void MCParticleBuilder::buildMCParticle(Trajectory* traj) {
     p->setEndpoint(endp);
 
     if (traj->GetParentID() > 0) {
-        IMPL::MCParticleImpl* parent = findMCParticle(traj->GetParentID());
-        if (parent != nullptr) {
-            p->addParent(parent);
+        G4VTrajectory* parentTraj = trackMap_->findTrajectory(traj->GetParentID());
+        if (parentTraj != nullptr) {
+            IMPL::MCParticleImpl* parent = getMCParticle(parentTraj->GetTrackID());
+            if (parent != nullptr) {
+                p->addParent(parent);
+            } else if (static_cast<Trajectory*>(parentTraj)->getSaveFlag()) {
+                // The parent comes later in the trajectory container.
+                unlinked_.push_back(std::make_pair(p, parentTraj->GetTrackID()));
+            }
         }
     }
 
@@ -71,6 +61,8 @@ void MCParticleBuilder::buildMCParticle(Trajectory* traj) {
         simStatus[EVENT::MCParticle::BITCreatedInSimulation] = 1;
         p->setSimulatorStatus(simStatus.to_ulong());
     }
+
+    return p;
 }
 
 IMPL::LCCollectionVec* MCParticleBuilder::buildMCParticleColl(const G4Event* anEvent) {
@@ -78,15 +70,33 @@ IMPL::LCCollectionVec* MCParticleBuilder::buildMCParticleColl(const G4Event* anE
     auto collVec = new IMPL::LCCollectionVec(EVENT::LCIO::MCPARTICLE);
     auto trajectories = anEvent->GetTrajectoryContainer();
 
+    std::fill(particles_.begin(), particles_.end(), nullptr);
+    unlinked_.clear();
+
     if (trajectories) {
 
-        buildParticleMap(trajectories, collVec);
+        collVec->reserve(trajectories->entries());
 
         for (auto trajectory : *trajectories->GetVector()) {
-            if (Trajectory::getTrajectory(trajectory)->getSaveFlag()) {
-                buildMCParticle(static_cast<Trajectory*>(trajectory));
+            auto traj = static_cast<Trajectory*>(trajectory);
+            if (traj->getSaveFlag()) {
+                auto particle = buildMCParticle(traj);
+                collVec->addElement(particle);
+                size_t trackID = traj->GetTrackID();
+                if (trackID >= particles_.size()) {
+                    particles_.resize(std::max(trackID + 1, 2 * particles_.size()), nullptr);
+                }
+                particles_[trackID] = particle;
+            }
+        }
+
+        for (auto& link : unlinked_) {
+            IMPL::MCParticleImpl* parent = getMCParticle(link.second);
+            if (parent != nullptr) {
+                link.first->addParent(parent);
             }
         }
+        unlinked_.clear();
     }
 
     return collVec;
@@ -0,0 +1,38 @@
+#include "MemoryBudgetMessenger.h"
+
+/*
+ * HPS
+ */
+#include "MemoryBudget.h"
+
+namespace hpssim {
+
+MemoryBudgetMessenger::MemoryBudgetMessenger() {
+
+    memoryDir_ = new G4UIdirectory("/hps/memory/", this);
+
+    limitCmd_ = new G4UIcmdWithADouble("/hps/memory/limit", this);
+    limitCmd_->SetGuidance("Set the memory limit of the event caches and track bookkeeping in MB (0 for no limit).");
+    limitCmd_->SetGuidance("Caches that do not fit use a compact layout, an index of the file or read it sequentially.");
+    limitCmd_->SetParameterName("limit", false);
+
+    printCmd_ = new G4UIcmdWithoutParameter("/hps/memory/print", this);
+    printCmd_->SetGuidance("Print the memory used by the event caches and track bookkeeping.");
+}
+
+MemoryBudgetMessenger::~MemoryBudgetMessenger() {
+    delete limitCmd_;
+    delete printCmd_;
+    delete memoryDir_;
+}
+
+void MemoryBudgetMessenger::SetNewValue(G4UIcommand* command, G4String newValues) {
+    if (command == limitCmd_) {
+        double limit = G4UIcommand::ConvertToDouble(newValues);
+        MemoryBudget::getBudget()->setLimit(limit > 0. ? limit * 1024. * 1024. : 0);
+    } else if (command == printCmd_) {
+        MemoryBudget::getBudget()->print(std::cout);
+    }
+}
+
+} // namespace hpssim
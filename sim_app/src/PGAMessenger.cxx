@@ -3,6 +3,7 @@
 #include "globals.hh"
 
 #include "BeamPrimaryGenerator.h"
+#include "GeneratorCacheRegistry.h"
 #include "GpsPrimaryGenerator.h"
 #include "LcioPrimaryGenerator.h"
 #include "LHEPrimaryGenerator.h"
@@ -26,6 +27,17 @@ PGAMessenger::PGAMessenger(PrimaryGeneratorAction* pga) : pga_(pga) {
 
     verboseCmd_ = new G4UIcmdWithAnInteger("/hps/generators/verbose", this);
 
+    planCmd_ = new G4UIcmdWithABool("/hps/generators/plan", this);
+    planCmd_->SetGuidance("Pre-draw the number of events sampled from each generator at the start of the run.");
+    planCmd_->SetParameterName("enable", true);
+    planCmd_->SetDefaultValue(true);
+
+    sharedCacheDirCmd_ = new G4UIcmdWithAString("/hps/generators/sharedCacheDir", this);
+    sharedCacheDirCmd_->SetGuidance("Share event caches with other processes through files in this directory, e.g. /dev/shm.");
+    sharedCacheDirCmd_->SetGuidance("Use an empty string to disable sharing caches between processes.");
+    sharedCacheDirCmd_->SetParameterName("dir", true);
+    sharedCacheDirCmd_->SetDefaultValue("");
+
     // Define valid source types (this should probably be static and go someplace else).
     sourceType_["TEST"]   = TEST;
     sourceType_["LHE"]    = LHE;
@@ -51,6 +63,10 @@ void PGAMessenger::SetNewValue(G4UIcommand* command, G4String newValues) {
         int newLevel = G4UIcommand::ConvertToInt(newValues);
         std::cout << "PrimaryGeneratorMessenger: Setting generator verbose level to " << newLevel << std::endl;
         pga_->setVerbose(newLevel);
+    } else if (command == planCmd_) {
+        pga_->setPlanSampling(G4UIcommand::ConvertToBool(newValues));
+    } else if (command == sharedCacheDirCmd_) {
+        GeneratorCacheRegistry::getRegistry()->setSharedMemoryDir(newValues);
     }
 }
 
@@ -6,6 +6,15 @@ namespace hpssim {
 
 SimPlugin* PluginLoader::create(std::string pluginName, std::string libName) {
 
+    // Is the plugin linked into the application?
+    const PluginRegistry::Entry* entry = PluginRegistry::getRegistry()->find(pluginName);
+    if (entry) {
+        std::cout << "PluginLoader: Creating plugin '" << pluginName << "' from registry" << std::endl;
+        SimPlugin* plugin = entry->create();
+        registeredPlugins_[plugin] = entry->destroy;
+        return plugin;
+    }
+
     std::cout << "PluginLoader: Creating plugin '" << pluginName << "' from lib '" << libName << "'" << std::endl;
 
     // Open a handle to the specific dynamic lib.
@@ -59,6 +68,15 @@ void PluginLoader::destroy(SimPlugin* plugin) {
 
         std::cout << "PluginLoader: Destroying plugin '" << plugin->getName() << "'" << std::endl;
 
+        // Was the plugin created from the registry?
+        auto registered = registeredPlugins_.find(plugin);
+        if (registered != registeredPlugins_.end()) {
+            PluginRegistry::DestroyFunction destroyIt = registered->second;
+            registeredPlugins_.erase(registered);
+            destroyIt(plugin);
+            return;
+        }
+
         // Get the lib handle for the plugin.
         void* handle = this->pluginHandles_[plugin];
 
@@ -2,6 +2,12 @@
 
 #include "PluginMessenger.h"
 
+// Geant4
+#include "G4RunManager.hh"
+
+// STL
+#include <iomanip>
+
 namespace hpssim {
 
 PluginManager::PluginManager() {
@@ -19,75 +25,101 @@ void PluginManager::initializePlugins() {
         plugin->getParameters().print(std::cout);
         plugin->initialize();
     }
+    updateSteppingFilters();
 }
 
 void PluginManager::beginRun(const G4Run* run) {
-    auto plugins = actions_[SimPlugin::RUN];
-    for (PluginVec::iterator it = plugins.begin(); it != plugins.end(); it++) {
-        (*it)->beginRun(run);
+    if (statsEnabled_) {
+        resetStats();
     }
+    dispatch(SimPlugin::RUN, [&](SimPlugin* plugin) {
+        plugin->beginRun(run);
+    });
 }
 
 void PluginManager::endRun(const G4Run* run) {
-    auto plugins = actions_[SimPlugin::RUN];
-    for (PluginVec::iterator it = plugins.begin(); it != plugins.end(); it++) {
-        (*it)->endRun(run);
+    dispatch(SimPlugin::RUN, [&](SimPlugin* plugin) {
+        plugin->endRun(run);
+    });
+    if (statsEnabled_) {
+        printStats(std::cout);
     }
 }
 
 void PluginManager::stepping(const G4Step* step) {
-    auto plugins = actions_[SimPlugin::STEPPING];
-    for (PluginVec::iterator it = plugins.begin(); it != plugins.end(); it++) {
-        (*it)->stepping(step);
+    bool boundary = step->GetPostStepPoint()->GetStepStatus() == fGeomBoundary;
+    int pdgCode = step->GetTrack()->GetDefinition()->GetPDGEncoding();
+    VolumeTags::Mask volumeTags = 0;
+    bool hasVolumeTags = false;
+    for (auto& entry : steppingPlugins_) {
+        const SimPlugin::SteppingFilter& filter = entry.filter;
+        if (filter.boundaryOnly && !boundary) {
+            continue;
+        }
+        if (filter.volumeTags) {
+            if (!hasVolumeTags) {
+                G4VPhysicalVolume* volume = step->GetPreStepPoint()->GetPhysicalVolume();
+                VolumeTags* tags = VolumeTags::getVolumeTags();
+                volumeTags = tags->getTags(volume) | (volume ? tags->getTags(volume->GetLogicalVolume()) : 0);
+                hasVolumeTags = true;
+            }
+            if (!(volumeTags & filter.volumeTags)) {
+                continue;
+            }
+        }
+        if (filter.pdgCodes.size()
+                && std::find(filter.pdgCodes.begin(), filter.pdgCodes.end(), pdgCode) == filter.pdgCodes.end()) {
+            continue;
+        }
+        if (statsEnabled_) {
+            call(*entry.stats, [&]() {
+                entry.plugin->stepping(step);
+            });
+        } else {
+            entry.plugin->stepping(step);
+        }
     }
 }
 
 void PluginManager::preTracking(const G4Track* track) {
-    auto plugins = actions_[SimPlugin::TRACKING];
-    for (PluginVec::iterator it = plugins.begin(); it != plugins.end(); it++) {
-        (*it)->preTracking(track);
-    }
+    dispatch(SimPlugin::TRACKING, [&](SimPlugin* plugin) {
+        plugin->preTracking(track);
+    });
 }
 
 void PluginManager::postTracking(const G4Track* track) {
-    auto plugins = actions_[SimPlugin::TRACKING];
-    for (PluginVec::iterator it = plugins.begin(); it != plugins.end(); it++) {
-        (*it)->postTracking(track);
-    }
+    dispatch(SimPlugin::TRACKING, [&](SimPlugin* plugin) {
+        plugin->postTracking(track);
+    });
 }
 
 void PluginManager::beginEvent(const G4Event* event) {
-    auto plugins = actions_[SimPlugin::EVENT];
-    for (PluginVec::iterator it = plugins.begin(); it != plugins.end(); it++) {
-        (*it)->beginEvent(event);
-    }
+    dispatch(SimPlugin::EVENT, [&](SimPlugin* plugin) {
+        plugin->beginEvent(event);
+    });
 }
 
 void PluginManager::endEvent(const G4Event* event) {
-    auto plugins = actions_[SimPlugin::EVENT];
-    for (PluginVec::iterator it = plugins.begin(); it != plugins.end(); it++) {
-        (*it)->endEvent(event);
-    }
+    dispatch(SimPlugin::EVENT, [&](SimPlugin* plugin) {
+        plugin->endEvent(event);
+    });
 }
 
 void PluginManager::generatePrimary(G4Event* event) {
-    auto plugins = actions_[SimPlugin::PRIMARY];
-    for (PluginVec::iterator it = plugins.begin(); it != plugins.end(); it++) {
-        (*it)->generatePrimary(event);
-    }
+    dispatch(SimPlugin::PRIMARY, [&](SimPlugin* plugin) {
+        plugin->generatePrimary(event);
+    });
 }
 
 G4ClassificationOfNewTrack PluginManager::stackingClassifyNewTrack(const G4Track* track) {
 
-    auto plugins = actions_[SimPlugin::STACKING];
-
     // Default value of a track is fUrgent.
     G4ClassificationOfNewTrack currentTrackClass = G4ClassificationOfNewTrack::fUrgent;
 
-    for (PluginVec::iterator it = plugins.begin(); it != plugins.end(); it++) {
+    dispatch(SimPlugin::STACKING, [&](SimPlugin* plugin) {
 
         // Get proposed new track classification from this plugin.
-        G4ClassificationOfNewTrack newTrackClass = (*it)->stackingClassifyNewTrack(track, currentTrackClass);
+        G4ClassificationOfNewTrack newTrackClass = plugin->stackingClassifyNewTrack(track, currentTrackClass);
 
         // Only set the current classification if the plugin changed it.
         if (newTrackClass != currentTrackClass) {
@@ -95,24 +127,42 @@ G4ClassificationOfNewTrack PluginManager::stackingClassifyNewTrack(const G4Track
             // Set the track classification from this plugin.
             currentTrackClass = newTrackClass;
         }
-    }
+    });
 
     // Return the current track classification.
     return currentTrackClass;
 }
 
 void PluginManager::stackingNewStage() {
-    auto plugins = actions_[SimPlugin::STACKING];
-    for (PluginVec::iterator it = plugins.begin(); it != plugins.end(); it++) {
-        (*it)->stackingNewStage();
-    }
+    dispatch(SimPlugin::STACKING, [](SimPlugin* plugin) {
+        plugin->stackingNewStage();
+    });
 }
 
 void PluginManager::stackingPrepareNewEvent() {
-    auto plugins = actions_[SimPlugin::STACKING];
-    for (PluginVec::iterator it = plugins.begin(); it != plugins.end(); it++) {
-        (*it)->stackingPrepareNewEvent();
-    }
+    dispatch(SimPlugin::STACKING, [](SimPlugin* plugin) {
+        plugin->stackingPrepareNewEvent();
+    });
+}
+
+bool PluginManager::stagingIsFirstStage(const G4Track* track) {
+    bool firstStage = false;
+    dispatch(SimPlugin::STAGING, [&](SimPlugin* plugin) {
+        if (!firstStage) {
+            firstStage = plugin->stagingIsFirstStage(track);
+        }
+    });
+    return firstStage;
+}
+
+bool PluginManager::stagingAcceptEvent(int stage) {
+    bool accept = true;
+    dispatch(SimPlugin::STAGING, [&](SimPlugin* plugin) {
+        if (!plugin->stagingAcceptEvent(stage)) {
+            accept = false;
+        }
+    });
+    return accept;
 }
 
 SimPlugin* PluginManager::findPlugin(const std::string& pluginName) {
@@ -166,16 +216,21 @@ void PluginManager::registerPlugin(SimPlugin* plugin) {
 
     // add to master list
     plugins_.push_back(plugin);
+    stats_[plugin];
+
+    updateSteppingFilters();
+    updateActionStats();
+    updateUserActions();
 }
 
 void PluginManager::deregisterPlugin(SimPlugin* plugin) {
 
     // deregister plugin actions
     for (auto action : plugin->getActions()) {
-        auto plugins = actions_[action];
-        std::vector<SimPlugin*>::iterator itPlugin = std::find(plugins_.begin(), plugins_.end(), plugin);
-        if (itPlugin != plugins_.end()) {
-            plugins_.erase(itPlugin);
+        PluginVec& plugins = actions_[action];
+        std::vector<SimPlugin*>::iterator itPlugin = std::find(plugins.begin(), plugins.end(), plugin);
+        if (itPlugin != plugins.end()) {
+            plugins.erase(itPlugin);
         }
     }
 
@@ -184,6 +239,82 @@ void PluginManager::deregisterPlugin(SimPlugin* plugin) {
     if (pos != plugins_.end()) {
         plugins_.erase(pos);
     }
+    stats_.erase(plugin);
+
+    updateSteppingFilters();
+    updateActionStats();
+    updateUserActions();
+}
+
+void PluginManager::setUserActions(G4UserSteppingAction* steppingAction, G4UserStackingAction* stackingAction) {
+    steppingAction_ = steppingAction;
+    stackingAction_ = stackingAction;
+    updateUserActions();
+}
+
+void PluginManager::updateSteppingFilters() {
+    steppingPlugins_.clear();
+    for (auto plugin : actions_[SimPlugin::STEPPING]) {
+        steppingPlugins_.push_back(SteppingEntry{plugin, plugin->getSteppingFilter(), &stats_[plugin][SimPlugin::STEPPING]});
+    }
+}
+
+void PluginManager::updateActionStats() {
+    for (size_t action = 0; action < actions_.size(); action++) {
+        actionStats_[action].clear();
+        for (auto plugin : actions_[action]) {
+            actionStats_[action].push_back(&stats_[plugin][action]);
+        }
+    }
+}
+
+void PluginManager::resetStats() {
+    for (auto& entry : stats_) {
+        entry.second = PluginStats();
+    }
+}
+
+void PluginManager::printStats(std::ostream& os) {
+    static const char* actionNames[] = {"", "run", "event", "stacking", "stepping", "tracking", "primary", "staging"};
+    std::streamsize precision = os.precision();
+    os << "PluginManager: Plugin hook statistics, timing 1 in " << statsInterval_ << " calls" << std::endl;
+    os << "  " << std::left << std::setw(32) << "plugin" << std::setw(10) << "action" << std::right
+            << std::setw(14) << "calls" << std::setw(14) << "time [s]" << std::setw(16) << "time/call [us]"
+            << std::endl;
+    for (auto plugin : plugins_) {
+        const PluginStats& stats = stats_[plugin];
+        for (size_t action = 0; action < stats.size(); action++) {
+            const HookStats& hookStats = stats[action];
+            if (!hookStats.calls) {
+                continue;
+            }
+            os << "  " << std::left << std::setw(32) << plugin->getName() << std::setw(10) << actionNames[action]
+                    << std::right << std::setw(14) << hookStats.calls;
+            if (hookStats.sampledCalls) {
+                double timePerCall = hookStats.sampledTime / hookStats.sampledCalls;
+                os << std::setw(14) << std::setprecision(4) << timePerCall * hookStats.calls
+                        << std::setw(16) << std::setprecision(4) << timePerCall * 1e6;
+            } else {
+                os << std::setw(14) << "-" << std::setw(16) << "-";
+            }
+            os << std::endl;
+        }
+    }
+    os.precision(precision);
+}
+
+void PluginManager::updateUserActions() {
+    G4RunManager* runManager = G4RunManager::GetRunManager();
+    if (!runManager) {
+        return;
+    }
+    if (steppingAction_) {
+        runManager->SetUserAction(hasPlugins(SimPlugin::STEPPING) ? steppingAction_ : (G4UserSteppingAction*) nullptr);
+    }
+    if (stackingAction_) {
+        bool stacking = hasPlugins(SimPlugin::STACKING) || hasPlugins(SimPlugin::STAGING);
+        runManager->SetUserAction(stacking ? stackingAction_ : (G4UserStackingAction*) nullptr);
+    }
 }
 
 void PluginManager::destroyPlugins() {
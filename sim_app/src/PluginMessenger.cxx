@@ -31,6 +31,22 @@ PluginMessenger::PluginMessenger(PluginManager* thePluginManager) :
     listCmd_ = new G4UIcommand("/hps/plugins/list", this);
     listCmd_->SetGuidance("List currently loaded plugins.");
     listCmd_->AvailableForStates(G4ApplicationState::G4State_Idle, G4ApplicationState::G4State_PreInit);
+
+    statsCmd_ = new G4UIcommand("/hps/plugins/stats", this);
+    statsCmd_->SetGuidance("Enable or disable counting and timing the plugin hooks, or print or reset the statistics.");
+    statsCmd_->SetGuidance("When enabled, the statistics are reset at the start of each run and printed at its end.");
+    statsCmd_->AvailableForStates(G4ApplicationState::G4State_Idle, G4ApplicationState::G4State_PreInit);
+    G4UIparameter* statsAction = new G4UIparameter("action", 's', true);
+    statsAction->SetParameterCandidates("on off print reset");
+    statsAction->SetDefaultValue("print");
+    statsCmd_->SetParameter(statsAction);
+
+    statsIntervalCmd_ = new G4UIcommand("/hps/plugins/statsInterval", this);
+    statsIntervalCmd_->SetGuidance("Time one in every this many calls of each plugin hook.");
+    statsIntervalCmd_->AvailableForStates(G4ApplicationState::G4State_Idle, G4ApplicationState::G4State_PreInit);
+    G4UIparameter* interval = new G4UIparameter("interval", 'i', false);
+    interval->SetParameterRange("interval > 0");
+    statsIntervalCmd_->SetParameter(interval);
 }
 
 PluginMessenger::~PluginMessenger() {
@@ -38,6 +54,8 @@ PluginMessenger::~PluginMessenger() {
     delete loadCmd_;
     delete destroyCmd_;
     delete listCmd_;
+    delete statsCmd_;
+    delete statsIntervalCmd_;
 }
 
 void PluginMessenger::SetNewValue(G4UIcommand* command, G4String newValues) {
@@ -58,6 +76,18 @@ void PluginMessenger::SetNewValue(G4UIcommand* command, G4String newValues) {
         pluginManager_->destroy(pluginName);
     } else if (command == listCmd_) {
         pluginManager_->print(std::cout);
+    } else if (command == statsCmd_) {
+        if (newValues == "on") {
+            pluginManager_->setStatsEnabled(true);
+        } else if (newValues == "off") {
+            pluginManager_->setStatsEnabled(false);
+        } else if (newValues == "reset") {
+            pluginManager_->resetStats();
+        } else {
+            pluginManager_->printStats(std::cout);
+        }
+    } else if (command == statsIntervalCmd_) {
+        pluginManager_->setStatsInterval(G4UIcommand::ConvertToInt(newValues));
     }
 }
 
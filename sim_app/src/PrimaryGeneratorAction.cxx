@@ -51,11 +51,8 @@ void PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent) {
             continue;
         }
 
-        // Get the list of event transforms to be applied to each generated event.
-        auto transforms = gen->getTransforms();
-
         // Generate N event samples based on sampling setting.
-        int nevents = gen->getEventSampling()->getNumberOfEvents(anEvent);
+        int nevents = gen->getNumberOfSamples(anEvent);
         if (verbose_ > 1) {
             std::cout << "PrimaryGeneratorAction: Sampling " << nevents << " events from '" << gen->getName() << "'"
                     << std::endl;
@@ -77,6 +74,11 @@ void PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent) {
                 // Apply event transforms to the overlay event.
                 gen->applyTransforms(overlayEvent);
 
+                // Events sampled by weight are unweighted.
+                if (gen->getReadMode() == PrimaryGenerator::Weighted) {
+                    gen->unweightEvent(overlayEvent);
+                }
+
                 if (verbose_ > 2) {
                     std::cout << "PrimaryGeneratorAction: Generator '" << gen->getName() << "' created "
                             << overlayEvent->GetNumberOfPrimaryVertex() << " vertices in sample " << iEvent
@@ -108,23 +110,81 @@ void PrimaryGeneratorAction::addGenerator(PrimaryGenerator* generator) {
     generators_.push_back(generator);
 }
 
-void PrimaryGeneratorAction::initialize() {
+void PrimaryGeneratorAction::setPlanSampling(bool planSampling) {
+    planSampling_ = planSampling;
+}
+
+void PrimaryGeneratorAction::initialize(const G4Run* aRun) {
     
     for (auto gen : generators_) {
-        
+
+        // Fuse the transforms so they can be applied to the event caches.
+        gen->compileTransforms();
+
         // Initialization for generators with files.
         if (gen->isFileBased()) {
             
-            // Queues up all files for the generator for processing.
-            gen->queueFiles();
-            
-            // Reads the next file from the generator.
-            gen->readNextFile();
+            // Queues up all files for the generator and reads the first one, reusing its cache if possible.
+            gen->rewindFiles();
         }
                 
         // Call generator's initialization hook.
         gen->initialize();
     }
+
+    if (planSampling_) {
+        planSampling(aRun);
+    } else {
+        for (auto gen : generators_) {
+            gen->clearSamplingPlan();
+        }
+    }
+}
+
+void PrimaryGeneratorAction::planSampling(const G4Run* aRun) {
+
+    int nEvents = aRun->GetNumberOfEventToBeProcessed();
+    long seed = CLHEP::HepRandom::getTheSeed();
+
+    for (unsigned iGen = 0; iGen < generators_.size(); iGen++) {
+
+        auto gen = generators_[iGen];
+
+        // Separate stream for each generator that is reproducible from the job seed and run number.
+        std::seed_seq seq{seed, (long) aRun->GetRunID(), (long) iGen};
+        std::mt19937 engine(seq);
+        gen->planSampling(nEvents, engine);
+
+        long demand = gen->getPlannedDemand();
+        if (verbose_ > 0) {
+            std::cout << "PrimaryGeneratorAction: Planned " << demand << " events from '" << gen->getName()
+                    << "' for " << nEvents << " events in run " << aRun->GetRunID() << std::endl;
+        }
+
+        if (!gen->isFileBased() || !demand) {
+            continue;
+        }
+
+        // Check that the input files have enough events before the run starts.
+        long available = gen->countAvailableEvents();
+        if (available < 0) {
+            if (verbose_ > 1) {
+                std::cout << "PrimaryGeneratorAction: Number of events available from '" << gen->getName()
+                        << "' is unknown" << std::endl;
+            }
+            continue;
+        }
+        if (gen->getReadMode() == PrimaryGenerator::PureRandom || gen->getReadMode() == PrimaryGenerator::Weighted) {
+            // Events are sampled with duplicates so any events will do.
+            demand = 1;
+        }
+        if (demand > available) {
+            std::cerr << "PrimaryGeneratorAction: Generator '" << gen->getName() << "' needs " << demand
+                    << " events but its files have " << available << std::endl;
+            G4Exception("PrimaryGeneratorAction::planSampling", "", FatalException,
+                    G4String("Event generator '" + gen->getName() + "' does not have enough events for the run."));
+        }
+    }
 }
 
 void PrimaryGeneratorAction::endEvent(const G4Event*) {
@@ -245,6 +305,30 @@ void PrimaryGeneratorAction::doNextRead(hpssim::PrimaryGenerator* gen) {
              */
             throw EndOfFileException();
       }
+    } else if (gen->getReadMode() == PrimaryGenerator::Weighted) {
+        /*
+         * Read a random event from this file in proportion to its weight, with duplicates.
+         */
+        if (gen->getNumEvents() > 0) {
+            long weightedEvent = gen->sampleWeightedEvent();
+            if (verbose_ > 2) {
+                std::cout << "PrimaryGeneratorAction: Reading weighted event " << weightedEvent << " from '"
+                << gen->getName() + "'" << std::endl;
+            }
+            if (gen->getReadFlag()) {
+                gen->readEvent(weightedEvent, false);
+            } else {
+                if (verbose_ >= 0) {
+                    std::cout << "PrimaryGeneratorAction: New event was not read from '" << gen->getName()
+                    << "' because read flag was set to 'false'." << std::endl;
+                }
+            }
+        } else {
+            /*
+             * Generator ran out of events so throw an exception that indicates this.
+             */
+            throw EndOfFileException();
+        }
     } else if(gen->getReadMode() == PrimaryGenerator::Random || gen->getReadMode() == PrimaryGenerator::Linear || gen->getReadMode() == PrimaryGenerator::SemiRandom){
         /*
          * Read an event from this cached events in the order determined by event_list_, which is initialized either linearly, randomly or semi-randomly.
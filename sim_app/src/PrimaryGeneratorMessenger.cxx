@@ -60,6 +60,7 @@ PrimaryGeneratorMessenger::PrimaryGeneratorMessenger(PrimaryGenerator* generator
     linearCmd_ = new G4UIcommand(G4String(genDir + "linear"), this);
     pureRandomCmd_ = new G4UIcommand(G4String(genDir + "purerandom"), this);
     semiRandomCmd_ = new G4UIcommand(G4String(genDir + "semirandom"), this);
+    weightedCmd_ = new G4UIcommand(G4String(genDir + "weighted"), this);
 }
 
 PrimaryGeneratorMessenger::~PrimaryGeneratorMessenger() {
@@ -147,6 +148,12 @@ void PrimaryGeneratorMessenger::SetNewValue(G4UIcommand* command, G4String newVa
                     G4String("The generator " + G4String(generator_->getName()) + " does not support random access."));
       }
       generator_->setReadMode(PrimaryGenerator::PureRandom);
+    } else if (command == weightedCmd_) {
+      if (!generator_->supportsRandomAccess()) {
+        G4Exception("", "", FatalException,
+                    G4String("The generator " + G4String(generator_->getName()) + " does not support random access."));
+      }
+      generator_->setReadMode(PrimaryGenerator::Weighted);
     } else if (command == sequentialCmd_) {
         generator_->setReadMode(PrimaryGenerator::Sequential);
     } else {
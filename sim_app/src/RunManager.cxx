@@ -28,13 +28,35 @@ RunManager::RunManager() : G4RunManager() {
     physListFactory_ = new G4PhysListFactory;
     physicsMessenger_ = new PhysicsMessenger(physListFactory_);
 
+    // Setup messenger for the memory budget.
+    memoryMessenger_ = new MemoryBudgetMessenger;
+
+    // Setup messenger for the trajectory points.
+    trajectoryMessenger_ = new TrajectoryPointMessenger;
+    storageMessenger_ = new TrajectoryStorageMessenger;
+
+    // Setup messenger for the volume tags.
+    volumesMessenger_ = new VolumeTagsMessenger;
+
     // Setup detector construction.
     detectorConstruction_ = new LCDDDetectorConstruction();
     SetUserInitialization(detectorConstruction_);
 }
 
 RunManager::~RunManager() {
+    // Installed user actions are deleted by Geant4.
+    PluginManager::getPluginManager()->setUserActions(nullptr, nullptr);
+    if (GetUserSteppingAction() != steppingAction_) {
+        delete steppingAction_;
+    }
+    if (GetUserStackingAction() != stackingAction_) {
+        delete stackingAction_;
+    }
     delete physicsMessenger_;
+    delete memoryMessenger_;
+    delete trajectoryMessenger_;
+    delete storageMessenger_;
+    delete volumesMessenger_;
     delete physListFactory_;
     delete lcioMgr_;
 }
@@ -70,8 +92,11 @@ void RunManager::Initialize() {
     SetUserAction(new UserTrackingAction);
     SetUserAction(new UserRunAction);
     SetUserAction(new UserEventAction);
-    SetUserAction(new SteppingAction);
-    SetUserAction(new UserStackingAction);
+
+    // The stepping and stacking actions are only installed while plugins use them.
+    steppingAction_ = new SteppingAction;
+    stackingAction_ = new UserStackingAction;
+    PluginManager::getPluginManager()->setUserActions(steppingAction_, stackingAction_);
 
     // Create the persistency manager (must go here to get pointer to track map).
     lcioMgr_ = new LcioPersistencyManager();
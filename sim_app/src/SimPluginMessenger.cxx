@@ -17,6 +17,14 @@ namespace hpssim {
         verboseCmd_->SetParameter(verbose);
         verboseCmd_->SetGuidance("Set the verbosity level of the sim plugin (1-4).");
         verboseCmd_->AvailableForStates(G4ApplicationState::G4State_PreInit, G4ApplicationState::G4State_Idle);
+
+        paramCmd_ = new G4UIcommand(std::string(getPath() + "param").c_str(), this);
+        G4UIparameter* name = new G4UIparameter("name", 's', false);
+        paramCmd_->SetParameter(name);
+        G4UIparameter* value = new G4UIparameter("value", 'd', false);
+        paramCmd_->SetParameter(value);
+        paramCmd_->SetGuidance("Set a double parameter of the sim plugin, which is read when it is initialized.");
+        paramCmd_->AvailableForStates(G4ApplicationState::G4State_PreInit, G4ApplicationState::G4State_Idle);
     }
 
     void SimPluginMessenger::SetNewValue(G4UIcommand *command, G4String newValue) {
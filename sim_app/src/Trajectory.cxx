@@ -1,7 +1,6 @@
 #include "Trajectory.h"
 
 // Geant4
-#include "G4TrajectoryPoint.hh"
 #include "G4VProcess.hh"
 
 // HPS
@@ -10,8 +9,6 @@
 
 namespace hpssim {
 
-G4Allocator<Trajectory> TrajectoryAllocator;
-
 Trajectory::Trajectory(const G4Track* aTrack) :
         genStatus_(0) {
 
@@ -47,10 +44,10 @@ Trajectory::Trajectory(const G4Track* aTrack) :
     // If the track has not been stepped, then only the first point is added.
     // Otherwise, the track has already been stepped so we add also its last location
     // which should be its endpoint.
-    trajPoints_ = new TrajectoryPointContainer();
-    trajPoints_->push_back(new G4TrajectoryPoint(aTrack->GetVertexPosition()));
+    pointRule_ = TrajectoryPointPolicy::getPolicy()->findRule(aTrack);
+    vertexPoint_.setPosition(aTrack->GetVertexPosition());
     if (aTrack->GetTrackStatus() == G4TrackStatus::fStopAndKill) {
-        trajPoints_->push_back(new G4TrajectoryPoint(aTrack->GetPosition()));
+        setEndPoint(aTrack->GetPosition(), false);
     }
 
     // Set generator status which was set by the primary generator.
@@ -64,17 +61,11 @@ Trajectory::Trajectory(const G4Track* aTrack) :
 }
 
 Trajectory::~Trajectory() {
-    // Delete trajectory points and their container.
-    size_t i;
-    for (i = 0; i < trajPoints_->size(); i++) {
-        delete (*trajPoints_)[i];
-    }
-    trajPoints_->clear();
-    delete trajPoints_;
 }
 
 void Trajectory::AppendStep(const G4Step* aStep) {
-    trajPoints_->push_back(new G4TrajectoryPoint(aStep->GetPostStepPoint()->GetPosition()));
+    ++nSteps_;
+    setEndPoint(aStep->GetPostStepPoint()->GetPosition(), pointRule_->keepPoint(aStep, nSteps_));
 }
 
 G4int Trajectory::GetTrackID() const {
@@ -102,11 +93,19 @@ G4ThreeVector Trajectory::GetInitialMomentum() const {
 }
 
 int Trajectory::GetPointEntries() const {
-    return trajPoints_->size();
+    return 1 + trajPoints_.size() + (hasEndPoint_ ? 1 : 0);
 }
 
 G4VTrajectoryPoint* Trajectory::GetPoint(G4int i) const {
-    return (*trajPoints_)[i];
+    const TrajectoryPoint* point;
+    if (i == 0) {
+        point = &vertexPoint_;
+    } else if ((size_t) i <= trajPoints_.size()) {
+        point = &trajPoints_[i - 1];
+    } else {
+        point = &endPoint_;
+    }
+    return const_cast<TrajectoryPoint*>(point);
 }
 
 void Trajectory::MergeTrajectory(G4VTrajectory* secondTrajectory) {
@@ -117,14 +116,14 @@ void Trajectory::MergeTrajectory(G4VTrajectory* secondTrajectory) {
     Trajectory* seco = (Trajectory*) secondTrajectory;
     G4int ent = seco->GetPointEntries();
     for (int i = 1; i < ent; i++) {
-        trajPoints_->push_back((*(seco->trajPoints_))[i]);
+        setEndPoint(static_cast<TrajectoryPoint*>(seco->GetPoint(i))->getPosition(), true);
     }
-    delete (*seco->trajPoints_)[0];
-    seco->trajPoints_->clear();
+    seco->trajPoints_.clear();
+    seco->hasEndPoint_ = false;
 }
 
 const G4ThreeVector Trajectory::getEndPoint() const {
-    return GetPoint(GetPointEntries() - 1)->GetPosition();
+    return hasEndPoint_ ? endPoint_.getPosition() : vertexPoint_.getPosition();
 }
 
 G4double Trajectory::getEnergy() const {
@@ -0,0 +1,78 @@
+#include "TrajectoryPointMessenger.h"
+
+/*
+ * HPS
+ */
+#include "TrajectoryPointPolicy.h"
+
+#include <sstream>
+
+namespace hpssim {
+
+TrajectoryPointMessenger::TrajectoryPointMessenger() {
+
+    trajectoryDir_ = new G4UIdirectory("/hps/trajectory/", this);
+    trajectoryDir_->SetGuidance("Commands for the points stored in trajectories.");
+
+    pointsCmd_ = new G4UIcommand("/hps/trajectory/points", this);
+    pointsCmd_->SetGuidance("Set which step points are stored in trajectories of a region or by default.");
+    pointsCmd_->SetGuidance("The vertex and end point are always stored.");
+    G4UIparameter* p = new G4UIparameter("mode", 's', false);
+    p->SetParameterCandidates("endpoints nth volumes full");
+    pointsCmd_->SetParameter(p);
+    p = new G4UIparameter("region", 's', true);
+    p->SetGuidance("Name of the region at the track vertex; if omitted sets the default.");
+    p->SetDefaultValue("");
+    pointsCmd_->SetParameter(p);
+
+    intervalCmd_ = new G4UIcommand("/hps/trajectory/pointInterval", this);
+    intervalCmd_->SetGuidance("Set the interval of the stored step points in nth mode.");
+    p = new G4UIparameter("interval", 'i', false);
+    p->SetParameterRange("interval > 0");
+    intervalCmd_->SetParameter(p);
+    p = new G4UIparameter("region", 's', true);
+    p->SetDefaultValue("");
+    intervalCmd_->SetParameter(p);
+
+    volumeCmd_ = new G4UIcommand("/hps/trajectory/addPointVolume", this);
+    volumeCmd_->SetGuidance("Add a logical volume whose step points are stored in volumes mode.");
+    p = new G4UIparameter("volume", 's', false);
+    volumeCmd_->SetParameter(p);
+    p = new G4UIparameter("region", 's', true);
+    p->SetDefaultValue("");
+    volumeCmd_->SetParameter(p);
+
+    printCmd_ = new G4UIcommand("/hps/trajectory/printPoints", this);
+    printCmd_->SetGuidance("Print the trajectory point policy.");
+}
+
+TrajectoryPointMessenger::~TrajectoryPointMessenger() {
+    delete pointsCmd_;
+    delete intervalCmd_;
+    delete volumeCmd_;
+    delete printCmd_;
+    delete trajectoryDir_;
+}
+
+void TrajectoryPointMessenger::SetNewValue(G4UIcommand* command, G4String newValues) {
+    std::istringstream is((const char*) newValues);
+    std::string value, region;
+    is >> value >> region;
+    TrajectoryPointPolicy* policy = TrajectoryPointPolicy::getPolicy();
+    if (command == pointsCmd_) {
+        TrajectoryPointPolicy::Mode mode;
+        if (!TrajectoryPointPolicy::toMode(value, mode)) {
+            G4Exception("TrajectoryPointMessenger::SetNewValue", "", FatalException,
+                    G4String("Invalid trajectory point mode '" + value + "'."));
+        }
+        policy->getRule(region).mode = mode;
+    } else if (command == intervalCmd_) {
+        policy->getRule(region).interval = G4UIcommand::ConvertToInt(value.c_str());
+    } else if (command == volumeCmd_) {
+        policy->getRule(region).volumes.insert(value);
+    } else if (command == printCmd_) {
+        policy->print(std::cout);
+    }
+}
+
+} // namespace hpssim
@@ -0,0 +1,108 @@
+#include "TrajectoryStorageMessenger.h"
+
+/*
+ * HPS
+ */
+#include "TrajectoryStoragePolicy.h"
+
+#include <sstream>
+
+namespace hpssim {
+
+TrajectoryStorageMessenger::TrajectoryStorageMessenger() {
+
+    storageDir_ = new G4UIdirectory("/hps/trajectory/storage/", this);
+    storageDir_->SetGuidance("Rules for storing the trajectories of secondary tracks.");
+    storageDir_->SetGuidance("The first matching rule applies; otherwise the region settings decide.");
+
+    addCmd_ = new G4UIcmdWithAString("/hps/trajectory/storage/add", this);
+    addCmd_->SetGuidance("Add a rule which stores or drops the trajectories of matching tracks.");
+    addCmd_->SetGuidance("The conditions of the rule are set by the commands which follow.");
+    addCmd_->SetParameterName("action", false);
+    addCmd_->SetCandidates("store drop");
+
+    particlesCmd_ = new G4UIcmdWithAString("/hps/trajectory/storage/particles", this);
+    particlesCmd_->SetGuidance("Set the particle names or PDG codes of the last rule, separated by spaces.");
+    particlesCmd_->SetParameterName("particles", false);
+
+    processCmd_ = new G4UIcmdWithAString("/hps/trajectory/storage/process", this);
+    processCmd_->SetGuidance("Set the creator process name of the last rule.");
+    processCmd_->SetParameterName("process", false);
+
+    minEnergyCmd_ = new G4UIcmdWithADoubleAndUnit("/hps/trajectory/storage/minEnergy", this);
+    minEnergyCmd_->SetGuidance("Set the minimum kinetic energy at the vertex of the last rule.");
+    minEnergyCmd_->SetParameterName("energy", false);
+    minEnergyCmd_->SetDefaultUnit("MeV");
+
+    maxEnergyCmd_ = new G4UIcmdWithADoubleAndUnit("/hps/trajectory/storage/maxEnergy", this);
+    maxEnergyCmd_->SetGuidance("Set the maximum kinetic energy at the vertex of the last rule.");
+    maxEnergyCmd_->SetParameterName("energy", false);
+    maxEnergyCmd_->SetDefaultUnit("MeV");
+
+    regionCmd_ = new G4UIcmdWithAString("/hps/trajectory/storage/region", this);
+    regionCmd_->SetGuidance("Set the region at the vertex of the last rule.");
+    regionCmd_->SetParameterName("region", false);
+
+    maxDepthCmd_ = new G4UIcmdWithAnInteger("/hps/trajectory/storage/maxDepth", this);
+    maxDepthCmd_->SetGuidance("Set the maximum depth in the ancestry of the last rule (1 for daughters of primaries).");
+    maxDepthCmd_->SetParameterName("depth", false);
+
+    clearCmd_ = new G4UIcmdWithoutParameter("/hps/trajectory/storage/clear", this);
+    clearCmd_->SetGuidance("Remove all storage rules.");
+
+    printCmd_ = new G4UIcmdWithoutParameter("/hps/trajectory/storage/print", this);
+    printCmd_->SetGuidance("Print the storage rules.");
+}
+
+TrajectoryStorageMessenger::~TrajectoryStorageMessenger() {
+    delete addCmd_;
+    delete particlesCmd_;
+    delete processCmd_;
+    delete minEnergyCmd_;
+    delete maxEnergyCmd_;
+    delete regionCmd_;
+    delete maxDepthCmd_;
+    delete clearCmd_;
+    delete printCmd_;
+    delete storageDir_;
+}
+
+void TrajectoryStorageMessenger::SetNewValue(G4UIcommand* command, G4String newValues) {
+    TrajectoryStoragePolicy* policy = TrajectoryStoragePolicy::getPolicy();
+    if (command == addCmd_) {
+        policy->addRule(newValues == "store");
+        return;
+    } else if (command == clearCmd_) {
+        policy->clear();
+        return;
+    } else if (command == printCmd_) {
+        policy->print(std::cout);
+        return;
+    }
+
+    TrajectoryStoragePolicy::Rule* rule = policy->getLastRule();
+    if (!rule) {
+        G4Exception("TrajectoryStorageMessenger::SetNewValue", "", FatalException,
+                "A storage rule must be added before setting its conditions.");
+    }
+    if (command == particlesCmd_) {
+        std::istringstream is((const char*) newValues);
+        std::string particle;
+        rule->particles.clear();
+        while (is >> particle) {
+            rule->particles.push_back(particle);
+        }
+    } else if (command == processCmd_) {
+        rule->process = newValues;
+    } else if (command == minEnergyCmd_) {
+        rule->minEnergy = G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValues);
+    } else if (command == maxEnergyCmd_) {
+        rule->maxEnergy = G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValues);
+    } else if (command == regionCmd_) {
+        rule->region = newValues;
+    } else if (command == maxDepthCmd_) {
+        rule->maxDepth = G4UIcommand::ConvertToInt(newValues);
+    }
+}
+
+} // namespace hpssim
@@ -1,5 +1,6 @@
 #include "UserEventAction.h"
 
+#include "EventArena.h"
 #include "PluginManager.h"
 #include "PrimaryGeneratorAction.h"
 #include "UserTrackingAction.h"
@@ -11,6 +12,9 @@ void UserEventAction::BeginOfEventAction(const G4Event* anEvent) {
     // Set for LCDD detectors.
     CurrentTrackState::setCurrentTrackID(-1);
 
+    // Start a new epoch for the track information and trajectories of this event.
+    EventArena::getArena()->beginEvent();
+
     // Clear the global track map.
     UserTrackingAction::getUserTrackingAction()->getTrackMap()->clear();
 
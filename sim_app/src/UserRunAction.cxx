@@ -2,6 +2,8 @@
 
 #include "LcioPersistencyManager.h"
 #include "PrimaryGeneratorAction.h"
+#include "TrajectoryStoragePolicy.h"
+#include "VolumeTags.h"
 
 namespace hpssim {
 
@@ -16,12 +18,18 @@ void UserRunAction::BeginOfRunAction(const G4Run* aRun) {
     // init LCIO persistence engine
     LcioPersistencyManager::getInstance()->Initialize();
 
+    // compile the trajectory storage rules now that regions and particles exist
+    TrajectoryStoragePolicy::getPolicy()->compile();
+
     // init the primary generators
-    PrimaryGeneratorAction::getPrimaryGeneratorAction()->initialize();
+    PrimaryGeneratorAction::getPrimaryGeneratorAction()->initialize(aRun);
 
     // init sim plugins e.g. read parameter settings into variables, etc.
     PluginManager::getPluginManager()->initializePlugins();
 
+    // build the volume tags after the plugins have defined theirs
+    VolumeTags::getVolumeTags()->build();
+
     // activate plugin manager's begin run action
     PluginManager::getPluginManager()->beginRun(aRun);
 }
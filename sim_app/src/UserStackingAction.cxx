@@ -2,17 +2,34 @@
 
 #include "PluginManager.h"
 
+#include "G4RunManager.hh"
+
 namespace hpssim {
 
 G4ClassificationOfNewTrack UserStackingAction::ClassifyNewTrack(const G4Track *aTrack) {
-    return PluginManager::getPluginManager()->stackingClassifyNewTrack(aTrack);
+    PluginManager* pluginManager = PluginManager::getPluginManager();
+    G4ClassificationOfNewTrack classification = pluginManager->stackingClassifyNewTrack(aTrack);
+
+    // Postpone the tracks which are not needed to decide whether to keep the event.
+    if (stage_ == 0 && classification == fUrgent && pluginManager->hasPlugins(SimPlugin::STAGING)
+            && !pluginManager->stagingIsFirstStage(aTrack)) {
+        classification = fWaiting;
+    }
+    return classification;
 }
 
 void UserStackingAction::NewStage() {
-    PluginManager::getPluginManager()->stackingNewStage();
+    PluginManager* pluginManager = PluginManager::getPluginManager();
+    pluginManager->stackingNewStage();
+    if (pluginManager->hasPlugins(SimPlugin::STAGING) && !pluginManager->stagingAcceptEvent(stage_)) {
+        // Drop the waiting tracks and do not write the event.
+        G4RunManager::GetRunManager()->AbortEvent();
+    }
+    ++stage_;
 }
 
 void UserStackingAction::PrepareNewEvent() {
+    stage_ = 0;
     PluginManager::getPluginManager()->stackingPrepareNewEvent();
 }
 
@@ -0,0 +1,45 @@
+#include "VolumeTagsMessenger.h"
+
+/*
+ * HPS
+ */
+#include "VolumeTags.h"
+
+#include <sstream>
+
+namespace hpssim {
+
+VolumeTagsMessenger::VolumeTagsMessenger() {
+
+    volumesDir_ = new G4UIdirectory("/hps/volumes/", this);
+    volumesDir_->SetGuidance("Commands for tagging geometry volumes.");
+
+    tagCmd_ = new G4UIcommand("/hps/volumes/tag", this);
+    tagCmd_->SetGuidance("Tag the physical and logical volumes whose names match a regular expression.");
+    G4UIparameter* p = new G4UIparameter("tag", 's', false);
+    tagCmd_->SetParameter(p);
+    p = new G4UIparameter("pattern", 's', false);
+    tagCmd_->SetParameter(p);
+
+    printCmd_ = new G4UIcmdWithoutParameter("/hps/volumes/print", this);
+    printCmd_->SetGuidance("Print the tags and the tagged volumes.");
+}
+
+VolumeTagsMessenger::~VolumeTagsMessenger() {
+    delete tagCmd_;
+    delete printCmd_;
+    delete volumesDir_;
+}
+
+void VolumeTagsMessenger::SetNewValue(G4UIcommand* command, G4String newValues) {
+    if (command == tagCmd_) {
+        std::istringstream is((const char*) newValues);
+        std::string tag, pattern;
+        is >> tag >> pattern;
+        VolumeTags::getVolumeTags()->defineTag(tag, pattern);
+    } else if (command == printCmd_) {
+        VolumeTags::getVolumeTags()->print(std::cout);
+    }
+}
+
+} // namespace hpssim
@@ -15,6 +15,7 @@
  * HPS
  */
 #include "RunManager.h"
+#include "TrajectoryPointPolicy.h"
 
 using namespace hpssim;
 
@@ -28,6 +29,9 @@ int main(int argc, char* argv[]) {
     G4UIExecutive* UIExec = 0;
     if (argc == 1) {
         UIExec = new G4UIExecutive(argc, argv);
+
+        // Store all trajectory points for visualization in interactive sessions.
+        TrajectoryPointPolicy::getPolicy()->getRule("").mode = TrajectoryPointPolicy::Full;
     }
 
     // Initialize the custom run manager.
@@ -0,0 +1,159 @@
+/**
+ * @file shared_cache_file_test.cxx
+ * @brief Test of several processes opening the same empty shared cache file at the same time
+ */
+
+/*
+ * C++
+ */
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * POSIX
+ */
+#include <sys/wait.h>
+#include <unistd.h>
+
+/*
+ * HPS
+ */
+#include "SharedCacheFile.h"
+
+using namespace hpssim;
+
+/** Time the builder takes to build the data [ms]. */
+static const int BUILD_TIME = 500;
+
+/** Time each process uses the data after it is complete [ms]. */
+static const int HOLD_TIME = 2000;
+
+/** Size of the data [bytes]. */
+static const size_t DATA_SIZE = 1 << 20;
+
+/** Exit codes of the child processes. */
+enum Result {
+    Built = 10,
+    Attached = 11,
+    Failed = 12,
+    Corrupt = 13,
+    Blocked = 14
+};
+
+/**
+ * Open the cache file, build it if it is empty and use it for a while.
+ */
+static int run(const std::string& dir, int startPipe) {
+
+    // Wait until the parent releases both processes.
+    char c;
+    if (read(startPipe, &c, 1) != 0) {
+        return Failed;
+    }
+    auto start = std::chrono::steady_clock::now();
+
+    std::shared_ptr<SharedCacheFile> file = SharedCacheFile::open(dir, "shared_cache_file_test");
+    if (!file) {
+        return Failed;
+    }
+    int result = Attached;
+    if (!file->isComplete()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(BUILD_TIME));
+        char* data = file->allocate(DATA_SIZE);
+        if (!data) {
+            return Failed;
+        }
+        for (size_t i = 0; i < DATA_SIZE; i++) {
+            data[i] = static_cast<char>(i % 251);
+        }
+        file->publish();
+        result = Built;
+    }
+    auto ready = std::chrono::steady_clock::now();
+
+    if (!file->isComplete() || file->getDataSize() != DATA_SIZE) {
+        return Corrupt;
+    }
+    const char* data = file->getData();
+    for (size_t i = 0; i < DATA_SIZE; i++) {
+        if (data[i] != static_cast<char>(i % 251)) {
+            return Corrupt;
+        }
+    }
+
+    // The data must be available as soon as it is built, while the builder is still using it.
+    if (std::chrono::duration_cast<std::chrono::milliseconds>(ready - start).count() > BUILD_TIME + HOLD_TIME / 2) {
+        return Blocked;
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(HOLD_TIME));
+    return result;
+}
+
+/**
+ * Start processes against an empty cache file at the same time and check that exactly one
+ * of them builds the data and the others use it without waiting for the builder to finish.
+ * @return The number of failures.
+ */
+static int test(int nProcesses) {
+
+    std::string base = access("/dev/shm", W_OK) ? "/tmp" : "/dev/shm";
+    std::string pattern = base + "/shared-cache-file-test-XXXXXX";
+    char* dir = mkdtemp(&pattern[0]);
+    if (!dir) {
+        std::cerr << "shared-cache-file-test: Failed to create a directory in " << base << std::endl;
+        return 1;
+    }
+
+    int startPipe[2];
+    if (pipe(startPipe)) {
+        std::cerr << "shared-cache-file-test: Failed to create a pipe" << std::endl;
+        return 1;
+    }
+
+    std::vector<pid_t> pids(nProcesses);
+    for (auto& pid : pids) {
+        pid = fork();
+        if (pid == 0) {
+            close(startPipe[1]);
+            _exit(run(dir, startPipe[0]));
+        }
+    }
+    close(startPipe[0]);
+    close(startPipe[1]);
+
+    int built = 0, attached = 0, failed = 0;
+    for (auto pid : pids) {
+        int status = 0;
+        int result = pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) ? WEXITSTATUS(status) : Failed;
+        if (result == Built) {
+            ++built;
+        } else if (result == Attached) {
+            ++attached;
+        } else {
+            std::cerr << "shared-cache-file-test: Process " << pid << " failed with result " << result
+                    << std::endl;
+            ++failed;
+        }
+    }
+    rmdir(dir);
+
+    if (failed || built != 1 || attached != nProcesses - 1) {
+        std::cerr << "shared-cache-file-test: FAILED with " << nProcesses << " processes: " << built
+                << " builders and " << attached << " users" << std::endl;
+        return 1;
+    }
+    std::cout << "shared-cache-file-test: OK with " << nProcesses << " processes" << std::endl;
+    return 0;
+}
+
+int main(int, char**) {
+    int failures = 0;
+    failures += test(2);
+    failures += test(4);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
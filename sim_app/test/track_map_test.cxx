@@ -0,0 +1,70 @@
+/**
+ * @file track_map_test.cxx
+ * @brief Test of the depths of tracks added to the TrackMap while its records grow
+ */
+
+/*
+ * C++
+ */
+#include <cstdlib>
+#include <iostream>
+
+/*
+ * HPS
+ */
+#include "TrackMap.h"
+
+using namespace hpssim;
+
+/**
+ * Check the depth of a track in the map.
+ * @return The number of failures.
+ */
+static int checkDepth(TrackMap& trackMap, G4int trackID, int expected) {
+    int depth = trackMap.getDepth(trackID);
+    if (depth != expected) {
+        std::cerr << "track-map-test: Track " << trackID << " has depth " << depth << " instead of "
+                << expected << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Add a parent and then children whose track IDs are past the end of the records, so the
+ * records are reallocated while the parent is looked up, and check the depths.
+ */
+int main(int, char**) {
+    int failures = 0;
+
+    TrackMap trackMap;
+    trackMap.addSecondary(1, 0);
+    failures += checkDepth(trackMap, 1, 0);
+
+    // The child's track ID forces the records to grow.
+    trackMap.addSecondary(3, 1);
+    failures += checkDepth(trackMap, 3, 1);
+
+    // A chain where every track ID is past the end of the records.
+    G4int parentID = 3;
+    for (int depth = 2; depth < 10; depth++) {
+        G4int trackID = 4 * parentID;
+        trackMap.addSecondary(trackID, parentID);
+        failures += checkDepth(trackMap, trackID, depth);
+        parentID = trackID;
+    }
+
+    // The depths start again in the next event.
+    trackMap.clear();
+    failures += checkDepth(trackMap, 3, -1);
+    trackMap.addSecondary(2, 0);
+    trackMap.addSecondary(1000, 2);
+    failures += checkDepth(trackMap, 1000, 1);
+
+    if (failures) {
+        std::cerr << "track-map-test: FAILED with " << failures << " failures" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "track-map-test: OK" << std::endl;
+    return EXIT_SUCCESS;
+}